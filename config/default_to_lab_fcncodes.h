@@ -35,12 +35,18 @@
 /*
 ** TO_LAB command codes
 */
-#define TO_LAB_NOOP_CC            0 /*  no-op command     */
-#define TO_LAB_RESET_STATUS_CC    1 /*  reset status      */
-#define TO_LAB_ADD_PKT_CC         2 /*  add packet        */
-#define TO_LAB_SEND_DATA_TYPES_CC 3 /*  send data types   */
-#define TO_LAB_REMOVE_PKT_CC      4 /*  remove packet     */
-#define TO_LAB_REMOVE_ALL_PKT_CC  5 /*  remove all packet */
-#define TO_LAB_OUTPUT_ENABLE_CC   6 /*  output enable     */
+#define TO_LAB_NOOP_CC                   0  /*  no-op command          */
+#define TO_LAB_RESET_STATUS_CC           1  /*  reset status           */
+#define TO_LAB_ADD_PKT_CC                2  /*  add packet             */
+#define TO_LAB_SEND_DATA_TYPES_CC        3  /*  send data types        */
+#define TO_LAB_REMOVE_PKT_CC             4  /*  remove packet          */
+#define TO_LAB_REMOVE_ALL_PKT_CC         5  /*  remove all packet      */
+#define TO_LAB_OUTPUT_ENABLE_CC          6  /*  output enable          */
+#define TO_LAB_CHANNEL_OUTPUT_ENABLE_CC  7  /*  channel output enable  */
+#define TO_LAB_CHANNEL_OUTPUT_DISABLE_CC 8  /*  channel output disable */
+#define TO_LAB_CHANNEL_ADD_PKT_CC        9  /*  channel add packet     */
+#define TO_LAB_CHANNEL_REMOVE_PKT_CC     10 /*  channel remove packet  */
+#define TO_LAB_SET_RATE_LIMIT_CC         11 /*  set rate limit         */
+#define TO_LAB_SET_COMPRESSION_CC        12 /*  set compression        */
 
 #endif
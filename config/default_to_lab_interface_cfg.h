@@ -42,4 +42,38 @@
  */
 #define TO_LAB_MAX_SUBSCRIPTIONS 32
 
+/**
+ * @brief The number of independent output channels
+ *
+ * Each channel has its own destination, subscriptions and section of the
+ * subscription table.  Channel N sends to TO_LAB_TLM_PORT + N by default.
+ */
+#define TO_LAB_MAX_CHANNELS 2
+
+/**
+ * @brief The maximum number of distinct streams TO_LAB keeps state for
+ *
+ * Also the number of entries in the stream telemetry packet.
+ */
+#define TO_LAB_MAX_STREAMS (TO_LAB_MAX_CHANNELS * TO_LAB_MAX_SUBSCRIPTIONS)
+
+/**
+ * @brief Subscription priority classes
+ *
+ * A subscription whose Flags.Priority is TO_LAB_PRIO_HIGH is placed on the
+ * channel's high-priority pipe, any other value on its low-priority pipe.
+ * The values double as indices into TO_LAB_Channel_t.Tlm_pipe.
+ */
+#define TO_LAB_PRIO_LOW  0
+#define TO_LAB_PRIO_HIGH 1
+#define TO_LAB_NUM_PRIO  2
+
+/**
+ * @brief The number of buckets in each extended HK histogram
+ *
+ * Buckets are powers of two, so 24 buckets resolve samples up to about 4
+ * million (4 seconds, in microseconds); the last bucket takes the rest.
+ */
+#define TO_LAB_HIST_BUCKETS 24
+
 #endif
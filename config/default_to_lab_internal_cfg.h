@@ -39,16 +39,378 @@
  */
 #define TO_LAB_TASK_MSEC 500 /* run at 2 Hz */
 
+/**
+ * @brief Event-driven telemetry forwarding
+ *
+ * When true, the main task pends on a wake pipe subscribed to every stream
+ * any channel carries, and drains the telemetry pipes each time a packet
+ * arrives, servicing the command pipe at least once every TO_LAB_TASK_MSEC.
+ * When false, the main task sleeps for TO_LAB_TASK_MSEC and then drains the
+ * telemetry pipes in a burst.
+ */
+#define TO_LAB_EVENT_DRIVEN_FORWARDING false
+
 /**
  * @brief Telemetry pipe timeout
  */
 #define TO_LAB_TLM_PIPE_TIMEOUT CFE_SB_POLL
 
 /**
- * @brief Maximum number of telemetry packets to send each wakeup
+ * @brief Initial and minimum number of packets each channel drains per pass
+ *
+ * A channel's drain budget adapts between this and TO_LAB_DRAIN_BUDGET_MAX:
+ * it doubles after a pass that stopped with packets still queued, and
+ * shrinks back toward twice the packets actually found once the backlog
+ * clears.
  */
 #define TO_LAB_MAX_TLM_PKTS OS_QUEUE_MAX_DEPTH
 
+/**
+ * @brief Largest number of packets a channel may drain per pass
+ */
+#define TO_LAB_DRAIN_BUDGET_MAX (8 * TO_LAB_MAX_TLM_PKTS)
+
+/**
+ * @brief Wall-clock limit on one drain pass, in milliseconds
+ *
+ * However large the drain budgets, a pass stops after this long so the
+ * command pipe is still serviced every cycle.  Budgets do not grow after a
+ * pass that was stopped by this limit.
+ */
+#define TO_LAB_DRAIN_SLICE_MSEC (TO_LAB_TASK_MSEC / 4)
+
+/**
+ * @brief High-priority packets served for each low-priority packet
+ *
+ * While both of a channel's pipes have traffic, the scheduler takes up to
+ * this many packets from the high-priority pipe before each packet from
+ * the low-priority pipe.
+ */
+#define TO_LAB_PRIO_HIGH_WEIGHT 4
+
+/**
+ * @brief Consecutive capped drain passes that count as a sustained backlog
+ *
+ * A drain pass that stops at its drain budget or time slice with packets
+ * still queued means the channel is falling behind.  After this many such passes in a
+ * row, TO_LAB_BACKLOG_ERR_EID is sent.
+ */
+#define TO_LAB_BACKLOG_CYCLES 4
+
+/**
+ * @brief Minimum time between backlog events on one channel
+ */
+#define TO_LAB_BACKLOG_EVENT_MSEC 10000
+
+/**
+ * @brief Bytes each channel may send per cycle before low priority defers
+ *
+ * A cycle is one TO_LAB_TASK_MSEC period.  Once a channel has sent this
+ * many bytes in the cycle, its low-priority pipe is left queued until the
+ * next cycle; high-priority packets are still sent.  Zero means no limit.
+ */
+#define TO_LAB_CYCLE_BYTE_BUDGET 0
+
+/**
+ * @brief Number of slots in the stream table's MsgId index
+ *
+ * Must be a power of two and larger than TO_LAB_MAX_STREAMS; about twice
+ * as large keeps lookups to one or two probes.
+ */
+#define TO_LAB_STREAM_HASH_SIZE 128
+
+/**
+ * @brief Default output rate limits of each channel
+ *
+ * Token bucket rates applied to everything a channel sends, in bytes and
+ * packets per second.  Zero means no limit.  They can be changed at
+ * runtime with the set rate limit command.
+ */
+#define TO_LAB_RATE_BYTES_PER_SEC 0
+#define TO_LAB_RATE_PKTS_PER_SEC  0
+
+/**
+ * @brief Deferral of packets over a rate limit
+ *
+ * When true, a packet over its channel or stream rate limit is queued in a
+ * hold ring until the limit lets it through.  When false, it is dropped
+ * and counted in TlmDeferDropCount, and the ring takes no memory.
+ */
+#define TO_LAB_RATE_DEFER_ENABLE false
+
+/**
+ * @brief Burst allowance of each rate limit token bucket
+ *
+ * A bucket holds at most this many milliseconds' worth of its rate.  It
+ * should be at least TO_LAB_TASK_MSEC, otherwise the burst drain at each
+ * wakeup cannot reach the configured rate.
+ */
+#define TO_LAB_RATE_BURST_MSEC TO_LAB_TASK_MSEC
+
+/**
+ * @brief Batched datagram output
+ *
+ * When true, encoded packets are packed into datagrams of up to
+ * TO_LAB_BATCH_MTU bytes using the length-delimited framing described in
+ * to_lab_output.h, instead of sending one datagram per packet.
+ */
+#define TO_LAB_BATCH_ENABLE false
+
+/**
+ * @brief Maximum size of a batched output datagram, in bytes
+ */
+#define TO_LAB_BATCH_MTU 1400
+
+/**
+ * @brief Maximum time a partially filled batch is held before it is sent
+ */
+#define TO_LAB_BATCH_MAX_AGE_MSEC 50
+
+/**
+ * @brief Vectored datagram submission
+ *
+ * When true, the datagrams produced by one drain cycle are collected and
+ * submitted to the socket layer together rather than one at a time.
+ */
+#define TO_LAB_VECTOR_SEND_ENABLE false
+
+/**
+ * @brief Maximum number of datagrams held awaiting a vectored submission
+ */
+#define TO_LAB_HOLD_RING_DEPTH 32
+
+/**
+ * @brief Bytes reserved for holding datagrams awaiting a vectored submission
+ *
+ * The rate limiter's deferral queue is a hold ring of the same
+ * dimensions.  Each ring is only allocated when the feature using it is
+ * enabled.
+ */
+#define TO_LAB_HOLD_RING_SIZE 16384
+
+/**
+ * @brief Datagram compression
+ *
+ * When true, each channel starts with compression enabled; it can be
+ * changed at runtime with the set compression command.  When false the
+ * compressor is left out, takes no memory, and cannot be turned on.  Datagrams of up
+ * to TO_LAB_COMPRESS_MAX_INPUT bytes are compressed against the last
+ * TO_LAB_COMPRESS_WINDOW bytes sent, using the format described in
+ * to_lab_compress.h.  The history is reset every
+ * TO_LAB_COMPRESS_RESET_DGRAMS datagrams, or never if zero, so the ground
+ * recovers from a lost datagram within that many.
+ *
+ * The window must be at least TO_LAB_COMPRESS_MAX_INPUT and below 32768.
+ */
+#define TO_LAB_COMPRESS_ENABLE       false
+#define TO_LAB_COMPRESS_WINDOW       8192
+#define TO_LAB_COMPRESS_MAX_INPUT    2048
+#define TO_LAB_COMPRESS_HASH_BITS    12
+#define TO_LAB_COMPRESS_RESET_DGRAMS 100
+
+/**
+ * @brief Delta encoding of streams subscribed with TO_LAB_SUB_OPT_DELTA
+ *
+ * The last packet sent of each such stream, per channel, is kept in a
+ * cache of TO_LAB_DELTA_CACHE_BYTES made of entries of
+ * TO_LAB_DELTA_MAX_PACKET bytes; packets larger than that are sent plain.
+ * When more streams need an entry than there are, the least recently used
+ * one is reassigned.  Every TO_LAB_DELTA_KEYFRAME_INTERVAL packets a
+ * stream is sent whole, so the ground recovers from a loss within that
+ * many.  See to_lab_delta.h.
+ */
+#define TO_LAB_DELTA_CACHE_BYTES       16384
+#define TO_LAB_DELTA_MAX_PACKET        512
+#define TO_LAB_DELTA_KEYFRAME_INTERVAL 30
+
+/**
+ * @brief Heartbeat of streams subscribed with TO_LAB_SUB_OPT_SKIP_SAME
+ *
+ * A packet whose payload is unchanged from the last one sent is still sent
+ * once this long has passed, so the ground can tell the stream is alive.
+ */
+#define TO_LAB_SKIP_SAME_HEARTBEAT_MSEC 10000
+
+/**
+ * @brief Backoff of datagrams retried after a transient send error
+ *
+ * The first retry waits TO_LAB_SEND_RETRY_MIN_MSEC and each further one
+ * twice as long, up to TO_LAB_SEND_RETRY_MAX_MSEC.  After
+ * TO_LAB_SEND_RETRY_LIMIT failed retries of the same datagram, output on
+ * the channel is suppressed as for a fatal error.
+ *
+ * When TO_LAB_SEND_RETRY_ENABLE is false, a datagram that meets a
+ * transient error is dropped and counted in SendRetryDropCount instead,
+ * and the retry queue is only allocated for non-blocking output.
+ */
+#define TO_LAB_SEND_RETRY_ENABLE   false
+#define TO_LAB_SEND_RETRY_MIN_MSEC 10
+#define TO_LAB_SEND_RETRY_MAX_MSEC 500
+#define TO_LAB_SEND_RETRY_LIMIT    10
+
+/**
+ * @brief Maximum number of datagrams, and bytes, in a channel's retry queue
+ *
+ * With TO_LAB_NONBLOCKING_OUTPUT the queue also holds the datagrams
+ * waiting for the socket, so it should cover the output of a drain cycle.
+ */
+#define TO_LAB_SEND_RETRY_RING_DEPTH 32
+#define TO_LAB_SEND_RETRY_RING_SIZE  16384
+
+/**
+ * @brief Non-blocking socket output
+ *
+ * When true, a send never waits for the socket.  A datagram the socket
+ * cannot take now waits, with the datagrams after it, in the retry queue,
+ * which is flushed as the socket becomes writable within the remainder of
+ * the cycle's TO_LAB_DRAIN_SLICE_MSEC.  The main task then never blocks on
+ * a congested link, and keeps serving commands and housekeeping.
+ */
+#define TO_LAB_NONBLOCKING_OUTPUT false
+
+/**
+ * @brief Stream (TCP) output
+ *
+ * A channel enabled with TO_LAB_TRANSPORT_TCP buffers up to
+ * TO_LAB_TCP_BUFFER_SIZE bytes of framed packets, and writes them once
+ * TO_LAB_TCP_COALESCE_BYTES are waiting or the oldest has waited
+ * TO_LAB_TCP_MAX_DELAY_MSEC.  A connect attempt is completed in the
+ * background, without blocking the app, and given up if the handshake
+ * takes longer than TO_LAB_TCP_CONNECT_MSEC, which must allow for the
+ * round trip to the destination.  A failed or lost connection is retried
+ * every TO_LAB_TCP_RECONNECT_MSEC.  See to_lab_tcp.h.
+ *
+ * When TO_LAB_TCP_ENABLE is false the buffers take no memory, and a
+ * channel cannot be enabled with TO_LAB_TRANSPORT_TCP.
+ */
+#define TO_LAB_TCP_ENABLE         false
+#define TO_LAB_TCP_BUFFER_SIZE    32768
+#define TO_LAB_TCP_COALESCE_BYTES 8192
+#define TO_LAB_TCP_MAX_DELAY_MSEC 50
+#define TO_LAB_TCP_CONNECT_MSEC   5000
+#define TO_LAB_TCP_RECONNECT_MSEC 1000
+
+/**
+ * @brief Connected output sockets
+ *
+ * When true, each channel socket is connected to its destination when
+ * output is enabled, and datagrams are written to it without an address,
+ * so the stack does not look up the route for every datagram.
+ */
+#define TO_LAB_CONNECTED_SOCKET false
+
+/**
+ * @brief Dedicated sender task
+ *
+ * When true, socket sends are made by a child task fed through a bounded
+ * ring, so the main task only receives and encodes.  See to_lab_sender.h.
+ * The ring is only allocated when this is true.
+ */
+#define TO_LAB_SENDER_TASK_ENABLE false
+
+/**
+ * @brief Maximum number of datagrams queued for the sender task
+ */
+#define TO_LAB_SEND_RING_DEPTH 64
+
+/**
+ * @brief Bytes reserved for datagrams queued for the sender task
+ *
+ * Should be at least twice the largest datagram TO_LAB can produce.
+ */
+#define TO_LAB_SEND_RING_SIZE 65536
+
+/**
+ * @brief Longest the main task waits for room in the send ring, in milliseconds
+ *
+ * A datagram that still does not fit after this long is dropped and counted.
+ */
+#define TO_LAB_SENDER_STALL_MSEC 20
+
+/**
+ * @brief Stack size and priority of the sender task
+ */
+#define TO_LAB_SENDER_STACK_SIZE 16384
+#define TO_LAB_SENDER_PRIORITY   75
+
+/**
+ * @brief Number of parallel encode worker tasks, 0 to encode in the main task
+ *
+ * See to_lab_encode_pool.h.  Intended for EDS builds on multi-core targets.
+ */
+#define TO_LAB_ENCODE_WORKERS 0
+
+/**
+ * @brief Number of packets that can be queued for or held by the encode workers
+ */
+#define TO_LAB_ENCODE_QUEUE_DEPTH 16
+
+/**
+ * @brief Packet buffer slab pool
+ *
+ * Buffers for packets queued to the encode workers come from three classes
+ * of fixed size buffers (see to_lab_slab.h).  Each queued packet takes two
+ * buffers, one for its input and one for its encoded output.  The large
+ * class must hold the largest message SB can deliver, which is checked at
+ * compile time.  The pool is only allocated when TO_LAB_ENCODE_WORKERS is
+ * non-zero.
+ */
+#define TO_LAB_SLAB_SMALL_SIZE   512
+#define TO_LAB_SLAB_SMALL_COUNT  32
+#define TO_LAB_SLAB_MEDIUM_SIZE  4096
+#define TO_LAB_SLAB_MEDIUM_COUNT 8
+#define TO_LAB_SLAB_LARGE_SIZE   CFE_MISSION_SB_MAX_SB_MSG_SIZE
+#define TO_LAB_SLAB_LARGE_COUNT  2
+
+/**
+ * @brief Longest the main task blocks at once waiting on an encode worker
+ */
+#define TO_LAB_ENCODE_WAIT_MSEC 10
+
+/**
+ * @brief Stack size and priority of each encode worker task
+ */
+#define TO_LAB_ENCODE_WORKER_STACK_SIZE 16384
+#define TO_LAB_ENCODE_WORKER_PRIORITY   75
+
+/**
+ * @brief Number of entries in the encoder's per-topic type cache
+ *
+ * Used by the EDS encoder to remember the resolved type of each telemetry
+ * topic.  Topics are mapped to entries by TopicId modulo this value.
+ */
+#define TO_LAB_ENCODE_CACHE_SIZE 64
+
+/**
+ * @brief Flat pack plans for EDS telemetry types
+ *
+ * When true, the EDS encoder flattens each telemetry type into a list of
+ * byte copy/swap operations the first time it is seen and uses that list
+ * for later packets.  Types that cannot be flattened (bit fields, computed
+ * error control fields, etc.) keep using the generic EdsLib packer.  Every
+ * plan is checked against the generic packer when it is built, on a packet
+ * whose payload bytes are all distinct and non-zero, and again on its
+ * first live packet.
+ */
+#define TO_LAB_PACK_PLAN_ENABLE true
+
+/**
+ * @brief Check every planned packet against the generic packer
+ *
+ * Doubles the encode cost; intended for integration testing.
+ */
+#define TO_LAB_PACK_PLAN_VERIFY false
+
+/**
+ * @brief Total number of pack plan operations shared by all cached types
+ */
+#define TO_LAB_PACK_PLAN_POOL_OPS 1024
+
+/**
+ * @brief Maximum nesting of containers and arrays a pack plan will follow
+ */
+#define TO_LAB_PACK_PLAN_MAX_DEPTH 8
+
 /**
  * Depth of pipe for commands to the TO_LAB application itself
  */
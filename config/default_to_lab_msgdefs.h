@@ -27,16 +27,100 @@
 #define TO_LAB_MSGDEFS_H
 
 #include "common_types.h"
+#include "to_lab_mission_cfg.h"
 #include "cfe_sb_extern_typedefs.h"
+#include "cfe_time_extern_typedefs.h"
 #include "to_lab_fcncodes.h"
 
 typedef struct
 {
-    uint8 CommandCounter;
-    uint8 CommandErrorCounter;
-    uint8 spareToAlign[2];
+    uint8  CommandCounter;
+    uint8  CommandErrorCounter;
+    uint8  spareToAlign[2];
+    uint32 TlmForwardedCount;    /**< Telemetry packets sent or queued to be sent */
+    uint32 TlmDatagramCount;     /**< Datagrams sent on the socket */
+    uint16 HeldBufCount;         /**< Datagrams currently held awaiting send */
+    uint16 HeldBufHighWater;     /**< Most datagrams held at once since reset */
+    uint32 EncodeCacheHits;      /**< Encoder type lookups served from cache */
+    uint32 EncodeCacheMisses;    /**< Encoder type lookups that had to be resolved */
+    uint32 TlmLatencyAvgMsec;    /**< Average SB timestamp to forwarding latency over the last HK interval */
+    uint32 TlmLatencyMaxMsec;    /**< Maximum SB timestamp to forwarding latency over the last HK interval */
+    uint32 TlmDeferredCount;     /**< Packets deferred by a rate limit */
+    uint32 TlmDeferDropCount;    /**< Packets dropped because the deferral queue was full */
+    uint16 TlmPipeHighWater;     /**< Most packets found queued on one pipe in one drain pass */
+    uint16 TlmSbPeakDepth;       /**< Peak telemetry pipe depth last reported by SB */
+    uint32 TlmCapHitCount;       /**< Drain passes stopped with packets still queued */
+    uint32 TlmSliceHitCount;     /**< Drain passes stopped by TO_LAB_DRAIN_SLICE_MSEC */
+    uint16 TlmDrainBudget;       /**< Largest channel drain budget, in packets per pass */
+    uint16 TlmBacklog;           /**< Packets found queued in the last drain pass, all channels */
+    uint16 SendRingCount;        /**< Datagrams queued for the sender task */
+    uint16 SendRingHighWater;    /**< Most datagrams queued for the sender task since reset */
+    uint32 SendStallCount;       /**< Datagrams that waited for room in the send ring */
+    uint32 SendRingDropCount;    /**< Datagrams dropped because the send ring stayed full */
+    uint16 EncodeQueueHighWater; /**< Most packets queued for the encode workers since reset */
+    uint16 EncodeInlineCount;    /**< Packets the encode workers could not take, encoded by the main task */
+    uint16 SlabInUse;            /**< Slab pool buffers allocated */
+    uint16 SlabHighWater;        /**< Most slab pool buffers allocated at once since reset */
+    uint32 SlabAllocFailCount;   /**< Slab pool requests that found no free buffer */
+    uint32 CompressInBytes;      /**< Datagram bytes given to the compressor */
+    uint32 CompressOutBytes;     /**< Bytes the compressor produced from them */
+    uint32 CompressUsec;         /**< Time spent compressing, in microseconds */
+    uint32 DeltaInBytes;         /**< Packet bytes given to the delta encoder */
+    uint32 DeltaOutBytes;        /**< Bytes the delta encoder produced from them */
+    uint32 DeltaKeyframeCount;   /**< Delta stream packets sent whole */
+    uint32 DeltaEvictCount;      /**< Delta reference copies dropped to make room */
+    uint32 TlmSkippedCount;      /**< Unchanged packets dropped by TO_LAB_SUB_OPT_SKIP_SAME */
+    uint32 TlmSkippedBytes;      /**< Bytes of those packets, before encoding */
+    uint32 SendTransientErrors;  /**< Socket sends failed with an error worth retrying */
+    uint32 SendFatalErrors;      /**< Socket sends failed with an error that stops output */
+    uint32 SendRetryCount;       /**< Datagrams sent on a retry after their own send failed */
+    uint32 SendRetryDropCount;   /**< Datagrams dropped instead of retried */
+    uint32 SendWouldBlockCount;  /**< Sends put off because the socket was not writable */
+    uint32 TcpConnectCount;      /**< Stream connections made */
+    uint32 TcpDisconnectCount;   /**< Stream connections lost */
+    uint32 TcpBytesSent;         /**< Bytes written to stream connections */
+    uint32 TcpPartialWrites;     /**< Stream writes the socket only partly accepted */
+    uint32 TcpDroppedBytes;      /**< Stream bytes dropped for lack of buffer or on a lost connection */
 } TO_LAB_HkTlm_Payload_t;
 
+/**
+ * Counters of one stream
+ */
+typedef struct
+{
+    CFE_SB_MsgId_t     MsgId;
+    uint32             DecimatedCount[TO_LAB_MAX_CHANNELS]; /**< Packets dropped by decimation, per channel */
+    uint32             SkippedCount;                        /**< Unchanged packets dropped, all channels */
+    uint32             ForwardedCount;                      /**< Packets forwarded, all channels */
+    uint32             ByteCount;                           /**< Encoded bytes forwarded, all channels */
+    uint32             EncodeErrorCount;                    /**< Packets that failed to encode */
+    uint32             SendErrorCount;                      /**< Packets dropped on a send error or full queue */
+    CFE_TIME_SysTime_t LastSeenTime;                        /**< Time the stream was last received */
+} TO_LAB_StreamStats_t;
+
+typedef struct
+{
+    uint16               NumStreams; /**< Number of valid entries in Stream */
+    uint8                Spare[2];
+    TO_LAB_StreamStats_t Stream[TO_LAB_MAX_STREAMS];
+} TO_LAB_StreamTlm_Payload_t;
+
+/**
+ * Log2 histogram; bucket N counts samples from 2^(N-1) to 2^N - 1
+ */
+typedef struct
+{
+    uint32 Bucket[TO_LAB_HIST_BUCKETS];
+} TO_LAB_Histogram_t;
+
+typedef struct
+{
+    TO_LAB_Histogram_t LatencyMsec; /**< SB timestamp to forwarding, in milliseconds */
+    TO_LAB_Histogram_t EncodeUsec;  /**< Time to encode one packet, in microseconds */
+    TO_LAB_Histogram_t SendUsec;    /**< Time in one socket send, in microseconds */
+    TO_LAB_Histogram_t DrainPkts;   /**< Packets drained per forwarding cycle */
+} TO_LAB_HkExtTlm_Payload_t;
+
 typedef struct
 {
     uint16 synch;
@@ -66,4 +150,55 @@ typedef struct
     char dest_IP[16];
 } TO_LAB_EnableOutput_Payload_t;
 
+/*
+** Output transports
+*/
+#define TO_LAB_TRANSPORT_UDP 0 /**< One datagram per packet, or per batch */
+#define TO_LAB_TRANSPORT_TCP 1 /**< Length-prefixed packets on a stream, see to_lab_tcp.h */
+
+typedef struct
+{
+    char   dest_IP[16];
+    uint16 dest_port;
+    uint8  Channel;
+    uint8  Transport; /**< TO_LAB_TRANSPORT_UDP or TO_LAB_TRANSPORT_TCP */
+} TO_LAB_EnableChannelOutput_Payload_t;
+
+typedef struct
+{
+    uint8 Channel;
+    uint8 Spare[3];
+} TO_LAB_DisableChannelOutput_Payload_t;
+
+typedef struct
+{
+    CFE_SB_MsgId_t Stream;
+    CFE_SB_Qos_t   Flags;
+    uint8          BufLimit;
+    uint8          Channel;
+} TO_LAB_AddChannelPacket_Payload_t;
+
+typedef struct
+{
+    CFE_SB_MsgId_t Stream;
+    uint8          Channel;
+    uint8          Spare[3];
+} TO_LAB_RemoveChannelPacket_Payload_t;
+
+typedef struct
+{
+    CFE_SB_MsgId_t Stream;      /**< Stream to limit, or an invalid MsgId for the whole channel */
+    uint32         BytesPerSec; /**< 0 for no limit */
+    uint32         PktsPerSec;  /**< 0 for no limit */
+    uint8          Channel;
+    uint8          Spare[3];
+} TO_LAB_SetRateLimit_Payload_t;
+
+typedef struct
+{
+    uint16 ResetInterval; /**< Datagrams between history resets, 0 for none */
+    uint8  Channel;
+    uint8  Enable; /**< Non-zero to compress this channel's datagrams */
+} TO_LAB_SetCompression_Payload_t;
+
 #endif
@@ -30,5 +30,7 @@
 #define TO_LAB_SEND_HK_MID    CFE_PLATFORM_CMD_TOPICID_TO_MIDV(CFE_MISSION_TO_LAB_SEND_HK_TOPICID)
 #define TO_LAB_HK_TLM_MID     CFE_PLATFORM_TLM_TOPICID_TO_MIDV(CFE_MISSION_TO_LAB_HK_TLM_TOPICID)
 #define TO_LAB_DATA_TYPES_MID CFE_PLATFORM_TLM_TOPICID_TO_MIDV(CFE_MISSION_TO_LAB_DATA_TYPES_TOPICID)
+#define TO_LAB_STREAM_TLM_MID CFE_PLATFORM_TLM_TOPICID_TO_MIDV(CFE_MISSION_TO_LAB_STREAM_TLM_TOPICID)
+#define TO_LAB_HK_EXT_TLM_MID CFE_PLATFORM_TLM_TOPICID_TO_MIDV(CFE_MISSION_TO_LAB_HK_EXT_TLM_TOPICID)
 
 #endif
@@ -52,6 +52,18 @@ typedef struct
     TO_LAB_DataTypes_Payload_t Payload;         /**< \brief Telemetry payload */
 } TO_LAB_DataTypesTlm_t;
 
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t  TelemetryHeader; /**< \brief Telemetry header */
+    TO_LAB_StreamTlm_Payload_t Payload;         /**< \brief Telemetry payload */
+} TO_LAB_StreamTlm_t;
+
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TelemetryHeader; /**< \brief Telemetry header */
+    TO_LAB_HkExtTlm_Payload_t Payload;         /**< \brief Telemetry payload */
+} TO_LAB_HkExtTlm_t;
+
 /******************************************************************************/
 
 /*
@@ -104,4 +116,40 @@ typedef struct
     TO_LAB_EnableOutput_Payload_t Payload;       /**< \brief Command payload */
 } TO_LAB_EnableOutputCmd_t;
 
+typedef struct
+{
+    CFE_MSG_CommandHeader_t              CommandHeader; /**< \brief Command header */
+    TO_LAB_EnableChannelOutput_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_EnableChannelOutputCmd_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t               CommandHeader; /**< \brief Command header */
+    TO_LAB_DisableChannelOutput_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_DisableChannelOutputCmd_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t           CommandHeader; /**< \brief Command header */
+    TO_LAB_AddChannelPacket_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_AddChannelPacketCmd_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t              CommandHeader; /**< \brief Command header */
+    TO_LAB_RemoveChannelPacket_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_RemoveChannelPacketCmd_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t       CommandHeader; /**< \brief Command header */
+    TO_LAB_SetRateLimit_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_SetRateLimitCmd_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t         CommandHeader; /**< \brief Command header */
+    TO_LAB_SetCompression_Payload_t Payload;       /**< \brief Command payload */
+} TO_LAB_SetCompressionCmd_t;
+
 #endif /* TO_LAB_MSGSTRUCT_H */
@@ -25,5 +25,6 @@
 
 #define TO_LAB_MAIN_TASK_PERF_ID   34
 #define TO_LAB_SOCKET_SEND_PERF_ID 35
+#define TO_LAB_SENDER_PERF_ID      36
 
 #endif
@@ -38,11 +38,23 @@
  * Macro Definitions
  ************************************************************************/
 
+/*
+** Subscription options
+*/
+#define TO_LAB_SUB_OPT_DELTA     0x0001 /**< Send as deltas against the last packet sent, see to_lab_delta.h */
+#define TO_LAB_SUB_OPT_SKIP_SAME 0x0002 /**< Drop packets whose payload is unchanged, but for a heartbeat */
+
 typedef struct
 {
     CFE_SB_MsgId_t Stream;
     CFE_SB_Qos_t   Flags;
     uint16         BufLimit;
+    uint32         BytesPerSec;     /**< Rate limit for this stream in bytes/second, 0 for none */
+    uint32         PktsPerSec;      /**< Rate limit for this stream in packets/second, 0 for none */
+    uint16         Decimation;      /**< Send one packet of every N, 0 or 1 sends all */
+    uint16         MinIntervalMsec; /**< Minimum time between packets sent, 0 for none */
+    uint16         Options;         /**< TO_LAB_SUB_OPT_ flags */
+    uint8          Spare[2];
 } TO_LAB_Sub_t;
 
 #endif
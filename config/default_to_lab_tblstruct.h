@@ -42,9 +42,20 @@
  * Type Definitions
  *************************************************************************/
 
+/**
+ * Subscriptions of one output channel
+ */
 typedef struct
 {
     TO_LAB_Sub_t Subs[TO_LAB_MAX_SUBSCRIPTIONS];
+} TO_LAB_ChannelSubs_t;
+
+/**
+ * Complete subscription table, one section per output channel
+ */
+typedef struct
+{
+    TO_LAB_ChannelSubs_t Channel[TO_LAB_MAX_CHANNELS];
 } TO_LAB_Subs_t;
 
 #endif
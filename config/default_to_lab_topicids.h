@@ -28,4 +28,8 @@
 #define CFE_MISSION_TO_LAB_HK_TLM_TOPICID     0x80
 #define CFE_MISSION_TO_LAB_DATA_TYPES_TOPICID 0x81
 
+/* Clear of the topic IDs used by the cFE core and the other lab and sample apps */
+#define CFE_MISSION_TO_LAB_STREAM_TLM_TOPICID 0xF0
+#define CFE_MISSION_TO_LAB_HK_EXT_TLM_TOPICID 0xF1
+
 #endif
@@ -47,6 +47,20 @@
 #define TO_LAB_NOOP_INF_EID          18
 #define TO_LAB_TBL_ERR_EID           19
 #define TO_LAB_ENCODE_ERR_EID        20
+#define TO_LAB_PACKPLAN_ERR_EID      21
+#define TO_LAB_CHANNEL_ERR_EID       22
+#define TO_LAB_TLMOUTDIS_INF_EID     23
+#define TO_LAB_RATELIMIT_INF_EID     24
+#define TO_LAB_RATELIMIT_ERR_EID     25
+#define TO_LAB_BACKLOG_ERR_EID       26
+#define TO_LAB_SENDER_ERR_EID        27
+#define TO_LAB_ENCODER_ERR_EID       28
+#define TO_LAB_COMPRESS_INF_EID      29
+#define TO_LAB_TLMOUTDEST_ERR_EID    30
+#define TO_LAB_TCP_INF_EID           31
+#define TO_LAB_TCP_ERR_EID           32
+#define TO_LAB_COMPRESS_ERR_EID      33
+#define TO_LAB_LEN_ERR_EID           34
 
 /******************************************************************************/
 
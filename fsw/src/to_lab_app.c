@@ -21,11 +21,15 @@
  *  This file contains the source code for the TO lab application
  */
 
+#include <stdio.h>
+
 #include "cfe.h"
 #include "cfe_config.h"
+#include "cfe_msgids.h"
 
 #include "to_lab_app.h"
 #include "to_lab_encode.h"
+#include "to_lab_output.h"
 #include "to_lab_eventids.h"
 #include "to_lab_msgids.h"
 #include "to_lab_perfids.h"
@@ -47,6 +51,7 @@ void TO_LAB_AppMain(void)
 {
     uint32       RunStatus = CFE_ES_RunStatus_APP_RUN;
     CFE_Status_t status;
+    uint16       i;
 
     CFE_ES_PerfLogEntry(TO_LAB_MAIN_TASK_PERF_ID);
 
@@ -65,13 +70,26 @@ void TO_LAB_AppMain(void)
     */
     while (CFE_ES_RunLoop(&RunStatus) == true)
     {
-        CFE_ES_PerfLogExit(TO_LAB_MAIN_TASK_PERF_ID);
+        /* Each channel starts the cycle with a full byte budget */
+        for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+        {
+            TO_LAB_Global.Channel[i].BudgetRemaining = TO_LAB_CYCLE_BYTE_BUDGET;
+        }
 
-        OS_TaskDelay(TO_LAB_TASK_MSEC);
+        if (TO_LAB_EVENT_DRIVEN_FORWARDING)
+        {
+            TO_LAB_pend_telemetry();
+        }
+        else
+        {
+            CFE_ES_PerfLogExit(TO_LAB_MAIN_TASK_PERF_ID);
 
-        CFE_ES_PerfLogEntry(TO_LAB_MAIN_TASK_PERF_ID);
+            OS_TaskDelay(TO_LAB_TASK_MSEC);
 
-        TO_LAB_forward_telemetry();
+            CFE_ES_PerfLogEntry(TO_LAB_MAIN_TASK_PERF_ID);
+
+            TO_LAB_forward_telemetry();
+        }
 
         TO_LAB_process_commands();
     }
@@ -86,13 +104,293 @@ void TO_LAB_AppMain(void)
 */
 void TO_LAB_delete_callback(void)
 {
+    uint16 i;
+
     OS_printf("TO delete callback -- Closing TO Network socket.\n");
-    if (TO_LAB_Global.downlink_on)
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        if (TO_LAB_Global.Channel[i].downlink_on)
+        {
+            OS_close(TO_LAB_Global.Channel[i].TLMsockid);
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_select_pipe() -- Pipe for a subscription's priority      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_SB_PipeId_t TO_LAB_select_pipe(const TO_LAB_Channel_t *Chan, CFE_SB_Qos_t Flags)
+{
+    if (Flags.Priority == TO_LAB_PRIO_HIGH)
+    {
+        return Chan->Tlm_pipe[TO_LAB_PRIO_HIGH];
+    }
+
+    return Chan->Tlm_pipe[TO_LAB_PRIO_LOW];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_note_subscribed() -- Remember that a channel subscribed  */
+/*                             a stream, and on which pipe         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_note_subscribed(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx, CFE_SB_Qos_t Flags)
+{
+    TO_LAB_Stream_t *Stream;
+
+    Stream = TO_LAB_StreamRegister(MsgId);
+    if (Stream == NULL)
+    {
+        return;
+    }
+
+    Stream->SubChannels |= (uint32)1 << ChannelIdx;
+
+    if (Flags.Priority == TO_LAB_PRIO_HIGH)
+    {
+        Stream->HighPrioChannels |= (uint32)1 << ChannelIdx;
+    }
+    else
+    {
+        Stream->HighPrioChannels &= ~((uint32)1 << ChannelIdx);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_note_unsubscribed() -- Forget a channel's subscription   */
+/*                               to a stream                       */
+/*                                                                 */
+/* The stream's decimation and options on the channel go with it,  */
+/* so a later subscription by command starts out undecimated.      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_note_unsubscribed(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx)
+{
+    TO_LAB_Stream_t *Stream;
+
+    Stream = TO_LAB_StreamLookup(MsgId);
+    if (Stream == NULL)
+    {
+        return;
+    }
+
+    Stream->SubChannels &= ~((uint32)1 << ChannelIdx);
+    Stream->HighPrioChannels &= ~((uint32)1 << ChannelIdx);
+
+    TO_LAB_StreamSetFilter(Stream, ChannelIdx, 0, 0);
+    Stream->Options[ChannelIdx] = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_subscribed_pipe() -- Pipe a channel subscribed a stream  */
+/*                             on                                  */
+/*                                                                 */
+/* A stream the stream table had no room for is taken to be on the */
+/* low priority pipe.                                              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_SB_PipeId_t TO_LAB_subscribed_pipe(const TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t MsgId)
+{
+    const TO_LAB_Stream_t *Stream;
+
+    Stream = TO_LAB_StreamLookup(MsgId);
+    if (Stream != NULL && (Stream->HighPrioChannels & ((uint32)1 << Chan->ChannelIdx)) != 0)
+    {
+        return Chan->Tlm_pipe[TO_LAB_PRIO_HIGH];
+    }
+
+    return Chan->Tlm_pipe[TO_LAB_PRIO_LOW];
+}
+
+/* Stream WakeChannels has one bit per channel */
+CompileTimeAssert(TO_LAB_MAX_CHANNELS <= 32, TO_LAB_WakeChannels_TooManyChannels);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_wake_subscribe() -- Note a channel subscribed to a       */
+/*                            stream                               */
+/*                                                                 */
+/* In event-driven mode the wake pipe is subscribed to the stream  */
+/* along with the first channel.  The main task pends on the wake  */
+/* pipe alone, and drains every telemetry pipe when it wakes.  A   */
+/* stream the stream table has no room for does not wake the task, */
+/* it is drained on the next wakeup or cycle.                      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_wake_subscribe(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx)
+{
+    TO_LAB_Stream_t *Stream;
+    CFE_Status_t     status;
+
+    if (!TO_LAB_EVENT_DRIVEN_FORWARDING)
+    {
+        return;
+    }
+
+    Stream = TO_LAB_StreamRegister(MsgId);
+    if (Stream == NULL)
+    {
+        return;
+    }
+
+    if (Stream->WakeChannels == 0)
+    {
+        status = CFE_SB_SubscribeEx(MsgId, TO_LAB_Global.Wake_pipe, CFE_SB_DEFAULT_QOS, TO_LAB_TLM_PIPE_DEPTH);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_SUBSCRIBE_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO Can't subscribe wake pipe to stream 0x%x status %i", __LINE__,
+                              (unsigned int)CFE_SB_MsgIdToValue(MsgId), (int)status);
+            return;
+        }
+    }
+
+    Stream->WakeChannels |= (uint32)1 << ChannelIdx;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_wake_unsubscribe() -- Note a channel unsubscribed from a */
+/*                              stream                             */
+/*                                                                 */
+/* The wake pipe is unsubscribed along with the last channel.      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_wake_unsubscribe(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx)
+{
+    TO_LAB_Stream_t *Stream;
+    CFE_Status_t     status;
+
+    if (!TO_LAB_EVENT_DRIVEN_FORWARDING)
+    {
+        return;
+    }
+
+    Stream = TO_LAB_StreamLookup(MsgId);
+    if (Stream == NULL || (Stream->WakeChannels & ((uint32)1 << ChannelIdx)) == 0)
+    {
+        return;
+    }
+
+    Stream->WakeChannels &= ~((uint32)1 << ChannelIdx);
+
+    if (Stream->WakeChannels == 0)
     {
-        OS_close(TO_LAB_Global.TLMsockid);
+        status = CFE_SB_Unsubscribe(MsgId, TO_LAB_Global.Wake_pipe);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_SUBSCRIBE_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO Can't unsubscribe wake pipe from stream 0x%x status %i", __LINE__,
+                              (unsigned int)CFE_SB_MsgIdToValue(MsgId), (int)status);
+        }
     }
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_init_channel() -- Create a channel's pipe and subscribe  */
+/*                          to its section of the table            */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_init_channel(uint16 ChannelIdx)
+{
+    CFE_Status_t      status;
+    uint16            i;
+    char              ToTlmPipeName[OS_MAX_API_NAME];
+    TO_LAB_Sub_t     *SubEntry;
+    TO_LAB_Stream_t  *Stream;
+    TO_LAB_Channel_t *Chan = &TO_LAB_Global.Channel[ChannelIdx];
+
+    Chan->ChannelIdx      = ChannelIdx;
+    Chan->downlink_on     = false;
+    Chan->tlm_dest_port   = TO_LAB_TLM_PORT + ChannelIdx;
+    Chan->BudgetRemaining = TO_LAB_CYCLE_BYTE_BUDGET;
+
+    /* Channel 0 keeps the traditional pipe name for its low-priority (default) pipe */
+    if (ChannelIdx == 0)
+    {
+        strcpy(ToTlmPipeName, "TO_LAB_TLM_PIPE");
+    }
+    else
+    {
+        snprintf(ToTlmPipeName, sizeof(ToTlmPipeName), "TO_LAB_TLM_PIPE_%u", (unsigned int)ChannelIdx);
+    }
+
+    /* Create TO TLM pipes */
+    status = CFE_SB_CreatePipe(&Chan->Tlm_pipe[TO_LAB_PRIO_LOW], TO_LAB_TLM_PIPE_DEPTH, ToTlmPipeName);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_TLMPIPE_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't create Tlm pipe status %i",
+                          __LINE__, (int)status);
+        return status;
+    }
+
+    snprintf(ToTlmPipeName, sizeof(ToTlmPipeName), "TO_LAB_HI_PIPE_%u", (unsigned int)ChannelIdx);
+
+    status = CFE_SB_CreatePipe(&Chan->Tlm_pipe[TO_LAB_PRIO_HIGH], TO_LAB_TLM_PIPE_DEPTH, ToTlmPipeName);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_TLMPIPE_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't create Tlm pipe status %i",
+                          __LINE__, (int)status);
+        return status;
+    }
+
+    TO_LAB_HoldInit(&Chan->HoldRing, Chan->HoldEntry, sizeof(Chan->HoldEntry), Chan->HoldData,
+                    sizeof(Chan->HoldData));
+    TO_LAB_HoldInit(&Chan->DeferRing, Chan->DeferEntry, sizeof(Chan->DeferEntry), Chan->DeferData,
+                    sizeof(Chan->DeferData));
+    TO_LAB_HoldInit(&Chan->Retry.Ring, Chan->RetryEntry, sizeof(Chan->RetryEntry), Chan->RetryData,
+                    sizeof(Chan->RetryData));
+
+    TO_LAB_RateLimitInit(&Chan->RateLimit, TO_LAB_Global.SubsTblPtr->Channel[ChannelIdx].Subs);
+
+    Chan->DrainBudget = TO_LAB_MAX_TLM_PKTS;
+
+    TO_LAB_CompressInit(&Chan->Compress, TO_LAB_COMPRESS_ENABLE, TO_LAB_COMPRESS_RESET_DGRAMS);
+
+    /* Subscriptions for TLM pipe*/
+    SubEntry = TO_LAB_Global.SubsTblPtr->Channel[ChannelIdx].Subs;
+    for (i = 0; i < TO_LAB_MAX_SUBSCRIPTIONS; i++)
+    {
+        if (CFE_SB_MsgId_Equal(SubEntry->Stream, CFE_SB_MSGID_RESERVED))
+        {
+            /* Only process until the end of list marker is found */
+            break;
+        }
+
+        status = CFE_SB_SubscribeEx(SubEntry->Stream, TO_LAB_select_pipe(Chan, SubEntry->Flags), SubEntry->Flags,
+                                    SubEntry->BufLimit);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_SUBSCRIBE_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO Can't subscribe to stream 0x%x status %i", __LINE__,
+                              (unsigned int)CFE_SB_MsgIdToValue(SubEntry->Stream), (int)status);
+        }
+        else
+        {
+            TO_LAB_note_subscribed(SubEntry->Stream, ChannelIdx, SubEntry->Flags);
+
+            Stream = TO_LAB_StreamLookup(SubEntry->Stream);
+            if (Stream != NULL)
+            {
+                TO_LAB_StreamSetFilter(Stream, ChannelIdx, SubEntry->Decimation, SubEntry->MinIntervalMsec);
+                Stream->Options[ChannelIdx] = SubEntry->Options;
+            }
+
+            TO_LAB_wake_subscribe(SubEntry->Stream, ChannelIdx);
+        }
+
+        ++SubEntry;
+    }
+
+    return status;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* TO_LAB_init() -- TO initialization                              */
@@ -100,24 +398,18 @@ void TO_LAB_delete_callback(void)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 CFE_Status_t TO_LAB_init(void)
 {
-    CFE_Status_t  status;
-    char          PipeName[16];
-    uint16        PipeDepth;
-    uint16        i;
-    char          ToTlmPipeName[16];
-    uint16        ToTlmPipeDepth;
-    void         *TblPtr;
-    TO_LAB_Sub_t *SubEntry;
-    char          VersionString[TO_LAB_CFG_MAX_VERSION_STR_LEN];
+    CFE_Status_t status;
+    char         PipeName[16];
+    uint16       PipeDepth;
+    uint16       i;
+    void        *TblPtr;
+    char         VersionString[TO_LAB_CFG_MAX_VERSION_STR_LEN];
 
     /* Zero out the global data structure */
     memset(&TO_LAB_Global, 0, sizeof(TO_LAB_Global));
 
-    TO_LAB_Global.downlink_on = false;
-    PipeDepth                 = TO_LAB_CMD_PIPE_DEPTH;
+    PipeDepth = TO_LAB_CMD_PIPE_DEPTH;
     strcpy(PipeName, "TO_LAB_CMD_PIPE");
-    ToTlmPipeDepth = TO_LAB_TLM_PIPE_DEPTH;
-    strcpy(ToTlmPipeName, "TO_LAB_TLM_PIPE");
 
     /*
     ** Register with EVS
@@ -135,6 +427,10 @@ CFE_Status_t TO_LAB_init(void)
         */
         CFE_MSG_Init(CFE_MSG_PTR(TO_LAB_Global.HkTlm.TelemetryHeader), CFE_SB_ValueToMsgId(TO_LAB_HK_TLM_MID),
                      sizeof(TO_LAB_Global.HkTlm));
+        CFE_MSG_Init(CFE_MSG_PTR(TO_LAB_Global.StreamTlm.TelemetryHeader), CFE_SB_ValueToMsgId(TO_LAB_STREAM_TLM_MID),
+                     sizeof(TO_LAB_Global.StreamTlm));
+        CFE_MSG_Init(CFE_MSG_PTR(TO_LAB_Global.HkExtTlm.TelemetryHeader), CFE_SB_ValueToMsgId(TO_LAB_HK_EXT_TLM_MID),
+                     sizeof(TO_LAB_Global.HkExtTlm));
 
         status = CFE_TBL_Register(&TO_LAB_Global.SubsTblHandle, "TO_LAB_Subs", sizeof(TO_LAB_Subs_t),
                                   CFE_TBL_OPT_DEFAULT, NULL);
@@ -187,38 +483,52 @@ CFE_Status_t TO_LAB_init(void)
         CFE_SB_Subscribe(CFE_SB_ValueToMsgId(TO_LAB_CMD_MID), TO_LAB_Global.Cmd_pipe);
         CFE_SB_Subscribe(CFE_SB_ValueToMsgId(TO_LAB_SEND_HK_MID), TO_LAB_Global.Cmd_pipe);
 
-        /* Create TO TLM pipe */
-        status = CFE_SB_CreatePipe(&TO_LAB_Global.Tlm_pipe, ToTlmPipeDepth, ToTlmPipeName);
-        if (status != CFE_SUCCESS)
-        {
-            CFE_EVS_SendEvent(TO_LAB_TLMPIPE_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't create Tlm pipe status %i",
-                              __LINE__, (int)status);
-        }
-    }
+        /* SB statistics report the true depth of the telemetry pipes */
+        CFE_SB_Subscribe(CFE_SB_ValueToMsgId(CFE_SB_STATS_TLM_MID), TO_LAB_Global.Cmd_pipe);
 
-    if (status == CFE_SUCCESS)
-    {
-        /* Subscriptions for TLM pipe*/
-        SubEntry = TO_LAB_Global.SubsTblPtr->Subs;
-        for (i = 0; i < TO_LAB_MAX_SUBSCRIPTIONS; i++)
+        if (TO_LAB_EVENT_DRIVEN_FORWARDING)
         {
-            if (!CFE_SB_IsValidMsgId(SubEntry->Stream))
+            status = CFE_SB_CreatePipe(&TO_LAB_Global.Wake_pipe, TO_LAB_TLM_PIPE_DEPTH, "TO_LAB_WAKE_PIPE");
+            if (status != CFE_SUCCESS)
             {
-                /* Only process until invalid MsgId is found*/
-                break;
+                CFE_EVS_SendEvent(TO_LAB_TLMPIPE_ERR_EID, CFE_EVS_EventType_ERROR,
+                                  "L%d TO Can't create wake pipe status %i", __LINE__, (int)status);
             }
+        }
 
-            status = CFE_SB_SubscribeEx(SubEntry->Stream, TO_LAB_Global.Tlm_pipe, SubEntry->Flags, SubEntry->BufLimit);
+        for (i = 0; i < TO_LAB_MAX_CHANNELS && status == CFE_SUCCESS; i++)
+        {
+            status = TO_LAB_init_channel(i);
             if (status != CFE_SUCCESS)
             {
-                CFE_EVS_SendEvent(TO_LAB_SUBSCRIBE_ERR_EID, CFE_EVS_EventType_ERROR,
-                                  "L%d TO Can't subscribe to stream 0x%x status %i", __LINE__,
-                                  (unsigned int)CFE_SB_MsgIdToValue(SubEntry->Stream), (int)status);
+                break;
             }
+        }
+    }
 
-            ++SubEntry;
+    if (status == CFE_SUCCESS)
+    {
+        status = TO_LAB_EncodeInit();
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_ENCODER_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't init encoder status %i",
+                              __LINE__, (int)status);
         }
+    }
+
+    if (status == CFE_SUCCESS && TO_LAB_ENCODE_WORKERS > 0)
+    {
+        TO_LAB_SlabInit();
+        status = TO_LAB_EncodePoolInit();
+    }
+
+    if (status == CFE_SUCCESS && TO_LAB_SENDER_TASK_ENABLE)
+    {
+        status = TO_LAB_SenderInit();
+    }
 
+    if (status == CFE_SUCCESS)
+    {
         CFE_Config_GetVersionString(VersionString, TO_LAB_CFG_MAX_VERSION_STR_LEN, "TO Lab", TO_LAB_VERSION,
                                     TO_LAB_BUILD_CODENAME, TO_LAB_LAST_OFFICIAL);
 
@@ -243,6 +553,8 @@ void TO_LAB_process_commands(void)
 {
     CFE_SB_Buffer_t *SBBufPtr;
     CFE_Status_t     Status;
+    CFE_SB_MsgId_t   MsgId;
+    CFE_MSG_Size_t   MsgSize;
 
     /* Exit command processing loop if no message received. */
     while (1)
@@ -253,7 +565,66 @@ void TO_LAB_process_commands(void)
             break;
         }
 
-        TO_LAB_TaskPipe(SBBufPtr);
+        /* SB statistics are another app's telemetry, not part of the TO_LAB command interface */
+        MsgId = CFE_SB_INVALID_MSG_ID;
+        CFE_MSG_GetMsgId(&SBBufPtr->Msg, &MsgId);
+        if (CFE_SB_MsgId_Equal(MsgId, CFE_SB_ValueToMsgId(CFE_SB_STATS_TLM_MID)))
+        {
+            MsgSize = 0;
+            CFE_MSG_GetSize(&SBBufPtr->Msg, &MsgSize);
+
+            if (MsgSize != sizeof(CFE_SB_StatsTlm_t))
+            {
+                CFE_EVS_SendEvent(TO_LAB_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
+                                  "L%d TO: Invalid SB stats length: MID = 0x%x, Len = %u, Expected = %u", __LINE__,
+                                  (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)MsgSize,
+                                  (unsigned int)sizeof(CFE_SB_StatsTlm_t));
+            }
+            else
+            {
+                TO_LAB_record_sb_stats((const CFE_SB_StatsTlm_t *)SBBufPtr);
+            }
+        }
+        else
+        {
+            TO_LAB_TaskPipe(SBBufPtr);
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_record_sb_stats() -- Take telemetry pipe depths from an  */
+/*                             SB statistics packet                */
+/*                                                                 */
+/* SB only sends its statistics when commanded, so these depths    */
+/* are as fresh as the last SB statistics request.                 */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_record_sb_stats(const CFE_SB_StatsTlm_t *StatsPtr)
+{
+    const CFE_SB_PipeDepthStats_t *PipeStats;
+    TO_LAB_Channel_t              *Chan;
+    uint32                         i;
+    uint16                         ChannelIdx;
+    uint16                         Prio;
+
+    for (i = 0; i < CFE_MISSION_SB_MAX_PIPES; i++)
+    {
+        PipeStats = &StatsPtr->Payload.PipeDepthStats[i];
+
+        for (ChannelIdx = 0; ChannelIdx < TO_LAB_MAX_CHANNELS; ChannelIdx++)
+        {
+            Chan = &TO_LAB_Global.Channel[ChannelIdx];
+
+            for (Prio = 0; Prio < TO_LAB_NUM_PRIO; Prio++)
+            {
+                if (CFE_RESOURCEID_TEST_EQUAL(PipeStats->PipeId, Chan->Tlm_pipe[Prio]))
+                {
+                    Chan->SbPeakDepth[Prio] = PipeStats->PeakQueueDepth;
+                }
+            }
+        }
     }
 }
 
@@ -262,11 +633,18 @@ void TO_LAB_process_commands(void)
 /* TO_LAB_openTLM() -- Open TLM                                    */
 /*                                                                 */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void TO_LAB_openTLM(void)
+void TO_LAB_openTLM(TO_LAB_Channel_t *Chan)
 {
-    int32 status;
+    int32           status;
+    OS_SocketType_t SocketType;
 
-    status = OS_SocketOpen(&TO_LAB_Global.TLMsockid, OS_SocketDomain_INET, OS_SocketType_DATAGRAM);
+    SocketType = OS_SocketType_DATAGRAM;
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        SocketType = OS_SocketType_STREAM;
+    }
+
+    status = OS_SocketOpen(&Chan->TLMsockid, OS_SocketDomain_INET, SocketType);
     if (status != OS_SUCCESS)
     {
         CFE_EVS_SendEvent(TO_LAB_TLMOUTSOCKET_ERR_EID, CFE_EVS_EventType_ERROR, "L%d, TO TLM socket error: %d",
@@ -278,62 +656,661 @@ void TO_LAB_openTLM(void)
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
-/* TO_LAB_forward_telemetry() -- Forward telemetry                 */
+/* TO_LAB_closeTLM() -- Close TLM                                  */
 /*                                                                 */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void TO_LAB_forward_telemetry(void)
+void TO_LAB_closeTLM(TO_LAB_Channel_t *Chan)
+{
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        TO_LAB_TcpClose(Chan);
+    }
+    else
+    {
+        OS_close(Chan->TLMsockid);
+    }
+
+    Chan->TLMsockid = OS_OBJECT_ID_UNDEFINED;
+    Chan->Connected = false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_record_latency() -- Account the latency of a packet from */
+/*                            its timestamp to being forwarded     */
+/*                                                                 */
+/* A zero PktTime means the packet carried no timestamp            */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_record_latency(CFE_TIME_SysTime_t PktTime)
+{
+    CFE_TIME_SysTime_t CurrTime;
+    CFE_TIME_SysTime_t Latency;
+    uint32             LatencyMsec;
+
+    if (PktTime.Seconds == 0 && PktTime.Subseconds == 0)
+    {
+        return;
+    }
+
+    CurrTime = CFE_TIME_GetTime();
+
+    if (CFE_TIME_Compare(PktTime, CurrTime) == CFE_TIME_A_GT_B)
+    {
+        /* Stamped in the future (e.g. time was adjusted), nothing meaningful to record */
+        return;
+    }
+
+    Latency     = CFE_TIME_Subtract(CurrTime, PktTime);
+    LatencyMsec = (Latency.Seconds * 1000) + (CFE_TIME_Sub2MicroSecs(Latency.Subseconds) / 1000);
+
+    TO_LAB_Global.LatencySumMsec += LatencyMsec;
+    ++TO_LAB_Global.LatencyCount;
+    TO_LAB_HistogramAdd(&TO_LAB_Global.HkExtTlm.Payload.LatencyMsec, LatencyMsec);
+
+    if (LatencyMsec > TO_LAB_Global.HkTlm.Payload.TlmLatencyMaxMsec)
+    {
+        TO_LAB_Global.HkTlm.Payload.TlmLatencyMaxMsec = LatencyMsec;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_output_packet() -- Encode and send one telemetry packet  */
+/*                                                                 */
+/* With encode workers, the packet is queued and written out by    */
+/* TO_LAB_EncodePoolCollect() once it is encoded.                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_output_packet(TO_LAB_Channel_t *Chan, const CFE_SB_Buffer_t *SBBufPtr)
+{
+    CFE_Status_t       CfeStatus;
+    CFE_SB_MsgId_t     MsgId;
+    CFE_TIME_SysTime_t CurrTime;
+    CFE_TIME_SysTime_t PktTime;
+    OS_time_t          EncodeStart;
+    TO_LAB_Stream_t   *Stream;
+    const void        *NetBufPtr;
+    size_t             NetBufSize;
+    uint32             PayloadHash;
+
+    MsgId       = CFE_SB_INVALID_MSG_ID;
+    PayloadHash = 0;
+    CFE_MSG_GetMsgId(&SBBufPtr->Msg, &MsgId);
+
+    CurrTime = CFE_TIME_GetTime();
+
+    Stream = TO_LAB_StreamLookup(MsgId);
+    if (Stream != NULL)
+    {
+        Stream->LastSeenTime = CurrTime;
+    }
+
+    if (Chan->suppress_sendto)
+    {
+        return;
+    }
+
+    if (Chan->downlink_on == true)
+    {
+        /* Decimated and unchanged packets are dropped before any encode or send cost */
+        if (Stream != NULL && (!TO_LAB_StreamFilterPass(Stream, Chan->ChannelIdx) ||
+                               !TO_LAB_StreamChangedPass(Stream, Chan->ChannelIdx, SBBufPtr, &PayloadHash)))
+        {
+            return;
+        }
+
+        /* Only telemetry with a secondary header carries a timestamp */
+        if (CFE_MSG_GetMsgTime(&SBBufPtr->Msg, &PktTime) != CFE_SUCCESS)
+        {
+            PktTime.Seconds    = 0;
+            PktTime.Subseconds = 0;
+        }
+
+        if (TO_LAB_EncodePoolSubmit(Chan, Stream, MsgId, PayloadHash, PktTime, SBBufPtr))
+        {
+            return;
+        }
+
+        CFE_ES_PerfLogEntry(TO_LAB_SOCKET_SEND_PERF_ID);
+
+        OS_GetLocalTime(&EncodeStart);
+        CfeStatus = TO_LAB_EncodeOutputMessage(SBBufPtr, TO_LAB_Global.EncodeBuffer,
+                                               sizeof(TO_LAB_Global.EncodeBuffer), &NetBufPtr, &NetBufSize);
+        TO_LAB_HistogramAddUsecSince(&TO_LAB_Global.HkExtTlm.Payload.EncodeUsec, EncodeStart);
+
+        TO_LAB_output_encoded(Chan, Stream, MsgId, PayloadHash, PktTime, CfeStatus, NetBufPtr, NetBufSize);
+
+        CFE_ES_PerfLogExit(TO_LAB_SOCKET_SEND_PERF_ID);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_output_encoded() -- Write out one encoded packet         */
+/*                                                                 */
+/* The encoded size is charged against the channel's byte budget.  */
+/* PktTime is the packet's timestamp, or zero if it has none.      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_output_encoded(TO_LAB_Channel_t *Chan, TO_LAB_Stream_t *Stream, CFE_SB_MsgId_t MsgId, uint32 PayloadHash,
+                           CFE_TIME_SysTime_t PktTime, CFE_Status_t EncodeStatus, const void *NetBufPtr,
+                           size_t NetBufSize)
+{
+    size_t DeltaSize;
+    int32  OsStatus;
+
+    if (EncodeStatus != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_ENCODE_ERR_EID, CFE_EVS_EventType_ERROR, "Error packing output: %d\n",
+                          (int)EncodeStatus);
+
+        if (Stream != NULL)
+        {
+            ++Stream->EncodeErrorCount;
+        }
+        return;
+    }
+
+    if (Stream != NULL && (Stream->Options[Chan->ChannelIdx] & TO_LAB_SUB_OPT_DELTA))
+    {
+        DeltaSize = TO_LAB_DeltaEncode(Stream, Chan->ChannelIdx, NetBufPtr, NetBufSize);
+        if (DeltaSize != 0)
+        {
+            NetBufPtr  = TO_LAB_Global.Delta.Output;
+            NetBufSize = DeltaSize;
+        }
+    }
+
+    /* A deferred packet is counted when it is released, a dropped one not at all */
+    OsStatus = TO_LAB_OutputLimitedWrite(Chan, MsgId, PktTime, NetBufPtr, NetBufSize);
+    if (OsStatus == OS_SUCCESS)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.TlmForwardedCount;
+        TO_LAB_record_latency(PktTime);
+    }
+
+    if (Stream != NULL)
+    {
+        if (OsStatus == OS_SUCCESS)
+        {
+            ++Stream->ForwardedCount;
+            Stream->ByteCount += NetBufSize;
+        }
+        else if (OsStatus < 0)
+        {
+            ++Stream->SendErrorCount;
+        }
+
+        /* Only a payload that will reach the ground can stand in for the ones after it */
+        if (OsStatus == OS_SUCCESS || OsStatus == TO_LAB_OUTPUT_DEFERRED)
+        {
+            TO_LAB_StreamChangedCommit(Stream, Chan->ChannelIdx, PayloadHash);
+        }
+        else if (Stream->Options[Chan->ChannelIdx] & TO_LAB_SUB_OPT_DELTA)
+        {
+            /* The next delta would refer to this lost packet */
+            TO_LAB_DeltaResetStream(Stream, Chan->ChannelIdx);
+        }
+    }
+
+    if (NetBufSize < Chan->BudgetRemaining)
+    {
+        Chan->BudgetRemaining -= NetBufSize;
+    }
+    else
+    {
+        Chan->BudgetRemaining = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_resolve_dest() -- Convert the destination to socket form */
+/*                                                                 */
+/* Called once per enable command, with the sender task idle.      */
+/* In connected mode the channel socket is also connected to it.   */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_resolve_dest(TO_LAB_Channel_t *Chan)
+{
+    int32 status;
+
+    OS_SocketAddrInit(&Chan->DestAddr, OS_SocketDomain_INET);
+    OS_SocketAddrSetPort(&Chan->DestAddr, Chan->tlm_dest_port);
+    status = OS_SocketAddrFromString(&Chan->DestAddr, Chan->tlm_dest_IP);
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_TLMOUTDEST_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO invalid destination %s, channel %u: %d", __LINE__, Chan->tlm_dest_IP,
+                          (unsigned int)Chan->ChannelIdx, (int)status);
+        return status;
+    }
+
+    if (TO_LAB_CONNECTED_SOCKET && Chan->Transport == TO_LAB_TRANSPORT_UDP)
+    {
+        /* Fixing the peer once lets the stack skip the route lookup on every send */
+        status = OS_SocketConnect(Chan->TLMsockid, &Chan->DestAddr, TO_LAB_TASK_MSEC);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_TLMOUTDEST_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO connect to %s port %u failed, channel %u: %d", __LINE__, Chan->tlm_dest_IP,
+                              (unsigned int)Chan->tlm_dest_port, (unsigned int)Chan->ChannelIdx, (int)status);
+            return status;
+        }
+
+        Chan->Connected = true;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_forward_from_pipe() -- Forward one packet from one of a  */
+/*                               channel's priority pipes          */
+/*                                                                 */
+/* Returns true if a packet was received                           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_forward_from_pipe(TO_LAB_Channel_t *Chan, uint16 Prio)
 {
-    OS_SockAddr_t    d_addr;
-    int32            OsStatus;
     CFE_Status_t     CfeStatus;
     CFE_SB_Buffer_t *SBBufPtr;
-    const void      *NetBufPtr;
-    size_t           NetBufSize;
-    uint32           PktCount = 0;
 
-    OS_SocketAddrInit(&d_addr, OS_SocketDomain_INET);
-    OS_SocketAddrSetPort(&d_addr, TO_LAB_TLM_PORT);
-    OS_SocketAddrFromString(&d_addr, TO_LAB_Global.tlm_dest_IP);
-    OsStatus = 0;
+    CfeStatus = CFE_SB_ReceiveBuffer(&SBBufPtr, Chan->Tlm_pipe[Prio], TO_LAB_TLM_PIPE_TIMEOUT);
+
+    if (CfeStatus == CFE_SUCCESS)
+    {
+        TO_LAB_output_packet(Chan, SBBufPtr);
+    }
+    /* If CFE_SB_status != CFE_SUCCESS, then no packet was received from CFE_SB_ReceiveBuffer() */
+
+    return (CfeStatus == CFE_SUCCESS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_forward_telemetry() -- Forward telemetry                 */
+/*                                                                 */
+/* Drains every channel once and accounts for the cycle.           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_forward_telemetry(void)
+{
+    TO_LAB_DrainStats_t Stats;
+
+    memset(&Stats, 0, sizeof(Stats));
+
+    TO_LAB_drain_channels(&Stats);
+    TO_LAB_drain_accounting(&Stats);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_drain_channels() -- Drain the telemetry pipes            */
+/*                                                                 */
+/* Channels are drained in turn, so a busy channel cannot starve   */
+/* the others.  The channel served first rotates from one cycle to */
+/* the next.                                                       */
+/*                                                                 */
+/* Within a channel, each turn takes up to TO_LAB_PRIO_HIGH_WEIGHT */
+/* packets from the high-priority pipe and then one from the low-  */
+/* priority pipe.  The low-priority pipe is left alone once the    */
+/* channel's byte budget for the cycle is spent.                   */
+/*                                                                 */
+/* A channel stops once Stats shows DrainBudget packets received   */
+/* in the cycle, so polls of an empty pipe cost nothing, and every */
+/* channel stops once the call has run                             */
+/* TO_LAB_DRAIN_SLICE_MSEC.  Stats accumulates over the cycle, as  */
+/* event-driven forwarding drains several times per cycle.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_drain_channels(TO_LAB_DrainStats_t *Stats)
+{
+    TO_LAB_Channel_t *Chan;
+    bool              IsDraining[TO_LAB_MAX_CHANNELS][TO_LAB_NUM_PRIO];
+    bool              AnyDraining;
+    OS_time_t         StartTime;
+    OS_time_t         CurrTime;
+    OS_time_t         SliceEnd;
+    uint16            i;
+    uint16            Weight;
+    uint16            ChannelIdx;
+
+    OS_GetLocalTime(&StartTime);
+
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        Chan = &TO_LAB_Global.Channel[i];
+
+        IsDraining[i][TO_LAB_PRIO_HIGH] = (Stats->PktCount[i] < Chan->DrainBudget);
+        IsDraining[i][TO_LAB_PRIO_LOW]  = IsDraining[i][TO_LAB_PRIO_HIGH];
+
+        /* With a sender task running, that task retries on its own timer */
+        if (!TO_LAB_Global.Sender.Running)
+        {
+            TO_LAB_OutputRetry(Chan);
+        }
+
+        /* Packets held back by a rate limit go ahead of anything new */
+        TO_LAB_OutputReleaseDeferred(Chan);
+    }
 
     do
     {
-        CfeStatus = CFE_SB_ReceiveBuffer(&SBBufPtr, TO_LAB_Global.Tlm_pipe, TO_LAB_TLM_PIPE_TIMEOUT);
+        AnyDraining = false;
 
-        if ((CfeStatus == CFE_SUCCESS) && (TO_LAB_Global.suppress_sendto == false))
+        for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
         {
-            OsStatus = OS_SUCCESS;
+            ChannelIdx = (TO_LAB_Global.NextChannel + i) % TO_LAB_MAX_CHANNELS;
+            Chan       = &TO_LAB_Global.Channel[ChannelIdx];
 
-            if (TO_LAB_Global.downlink_on == true)
+            /* Over the channel rate limit, leave the rest queued in SB */
+            if (!TO_LAB_RateLimitChannelOpen(&Chan->RateLimit))
             {
-                CFE_ES_PerfLogEntry(TO_LAB_SOCKET_SEND_PERF_ID);
+                IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] = false;
+                IsDraining[ChannelIdx][TO_LAB_PRIO_LOW]  = false;
+            }
 
-                CfeStatus = TO_LAB_EncodeOutputMessage(SBBufPtr, &NetBufPtr, &NetBufSize);
+            for (Weight = 0; Weight < TO_LAB_PRIO_HIGH_WEIGHT && IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] &&
+                             Stats->PktCount[ChannelIdx] < Chan->DrainBudget;
+                 Weight++)
+            {
+                IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] = TO_LAB_forward_from_pipe(Chan, TO_LAB_PRIO_HIGH);
+                Stats->PktCount[ChannelIdx] += IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH];
+                Stats->PipeCount[ChannelIdx][TO_LAB_PRIO_HIGH] += IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH];
+            }
 
-                if (CfeStatus != CFE_SUCCESS)
-                {
-                    CFE_EVS_SendEvent(TO_LAB_ENCODE_ERR_EID, CFE_EVS_EventType_ERROR, "Error packing output: %d\n",
-                                      (int)CfeStatus);
-                }
-                else
+            if (TO_LAB_CYCLE_BYTE_BUDGET != 0 && Chan->BudgetRemaining == 0)
+            {
+                IsDraining[ChannelIdx][TO_LAB_PRIO_LOW] = false;
+            }
+
+            if (IsDraining[ChannelIdx][TO_LAB_PRIO_LOW] && Stats->PktCount[ChannelIdx] < Chan->DrainBudget)
+            {
+                IsDraining[ChannelIdx][TO_LAB_PRIO_LOW] = TO_LAB_forward_from_pipe(Chan, TO_LAB_PRIO_LOW);
+                Stats->PktCount[ChannelIdx] += IsDraining[ChannelIdx][TO_LAB_PRIO_LOW];
+                Stats->PipeCount[ChannelIdx][TO_LAB_PRIO_LOW] += IsDraining[ChannelIdx][TO_LAB_PRIO_LOW];
+            }
+
+            if (Stats->PktCount[ChannelIdx] >= Chan->DrainBudget)
+            {
+                /* Budget spent with a pipe whose last poll still yielded a packet, or was not polled */
+                Stats->CapHit[ChannelIdx] |=
+                    IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] || IsDraining[ChannelIdx][TO_LAB_PRIO_LOW];
+
+                IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] = false;
+                IsDraining[ChannelIdx][TO_LAB_PRIO_LOW]  = false;
+            }
+
+            AnyDraining |= IsDraining[ChannelIdx][TO_LAB_PRIO_HIGH] | IsDraining[ChannelIdx][TO_LAB_PRIO_LOW];
+        }
+
+        /* Leave the rest for the next pass rather than hold up command processing */
+        if (AnyDraining)
+        {
+            OS_GetLocalTime(&CurrTime);
+            if (OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, StartTime)) >= TO_LAB_DRAIN_SLICE_MSEC)
+            {
+                for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
                 {
-                    OsStatus = OS_SocketSendTo(TO_LAB_Global.TLMsockid, NetBufPtr, NetBufSize, &d_addr);
+                    Stats->CapHit[i] |= IsDraining[i][TO_LAB_PRIO_HIGH] || IsDraining[i][TO_LAB_PRIO_LOW];
                 }
 
-                CFE_ES_PerfLogExit(TO_LAB_SOCKET_SEND_PERF_ID);
+                Stats->SliceHit = true;
+                AnyDraining     = false;
+                ++TO_LAB_Global.HkTlm.Payload.TlmSliceHitCount;
             }
+        }
+    } while (AnyDraining);
+
+    /* Everything drained this pass is written out before the batches are flushed */
+    TO_LAB_EncodePoolCollect(true);
+
+    SliceEnd = OS_TimeAdd(StartTime, OS_TimeFromTotalMilliseconds(TO_LAB_DRAIN_SLICE_MSEC));
+
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        Chan = &TO_LAB_Global.Channel[i];
+
+        if (TO_LAB_EVENT_DRIVEN_FORWARDING)
+        {
+            TO_LAB_OutputCheckAge(Chan);
+        }
+        else
+        {
+            /* The task sleeps longer than any batch age limit, so send it now */
+            TO_LAB_OutputFlush(Chan);
+        }
+
+        /* Everything produced by this drain goes out in one submission */
+        TO_LAB_OutputSubmitVector(Chan);
+
+        /* Whatever the socket could not take waits for it until the slice ends */
+        if (TO_LAB_NONBLOCKING_OUTPUT && !TO_LAB_Global.Sender.Running)
+        {
+            TO_LAB_OutputFlushPending(Chan, SliceEnd);
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_drain_accounting() -- Account for one cycle's drains     */
+/*                                                                 */
+/* Called once per cycle, after the last TO_LAB_drain_channels().  */
+/* Updates the backlog tracking, drain budgets and statistics, and */
+/* rotates the channel served first.                               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_drain_accounting(const TO_LAB_DrainStats_t *Stats)
+{
+    TO_LAB_Channel_t *Chan;
+    uint32            Drained;
+    uint32            Found;
+    uint16            Prio;
+    uint16            i;
+
+    Drained = 0;
+
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        Chan = &TO_LAB_Global.Channel[i];
+
+        /* Packets found queued on a pipe are a lower bound on its depth */
+        Found = 0;
+        for (Prio = 0; Prio < TO_LAB_NUM_PRIO; Prio++)
+        {
+            Found += Stats->PipeCount[i][Prio];
 
-            if (OsStatus < 0)
+            if (Stats->PipeCount[i][Prio] > Chan->PipeHighWater[Prio])
             {
-                CFE_EVS_SendEvent(TO_LAB_TLMOUTSTOP_ERR_EID, CFE_EVS_EventType_ERROR,
-                                  "L%d TO sendto error %d. Tlm output suppressed\n", __LINE__, (int)OsStatus);
-                TO_LAB_Global.suppress_sendto = true;
+                Chan->PipeHighWater[Prio] = Stats->PipeCount[i][Prio];
             }
         }
-        /* If CFE_SB_status != CFE_SUCCESS, then no packet was received from CFE_SB_ReceiveBuffer() */
 
-        PktCount++;
-    } while (CfeStatus == CFE_SUCCESS && PktCount < TO_LAB_MAX_TLM_PKTS);
+        Drained += Found;
+
+        TO_LAB_check_backlog(Chan, Stats->CapHit[i]);
+        TO_LAB_adapt_drain_budget(Chan, Found, Stats->CapHit[i], Stats->SliceHit);
+    }
+
+    TO_LAB_Global.HkTlm.Payload.TlmBacklog = (uint16)(Drained < 0xFFFF ? Drained : 0xFFFF);
+
+    TO_LAB_HistogramAdd(&TO_LAB_Global.HkExtTlm.Payload.DrainPkts, Drained);
+
+    TO_LAB_Global.NextChannel = (TO_LAB_Global.NextChannel + 1) % TO_LAB_MAX_CHANNELS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_check_backlog() -- Track drain passes stopped by the     */
+/*                           packet cap                            */
+/*                                                                 */
+/* A run of TO_LAB_BACKLOG_CYCLES capped passes is reported, at    */
+/* most once every TO_LAB_BACKLOG_EVENT_MSEC per channel.  SB      */
+/* starts dropping packets once the backlog reaches a              */
+/* subscription's BufLimit or the pipe depth.                      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_check_backlog(TO_LAB_Channel_t *Chan, bool CapHit)
+{
+    OS_time_t CurrTime;
+
+    if (!CapHit)
+    {
+        Chan->BacklogCycles = 0;
+        return;
+    }
+
+    ++TO_LAB_Global.HkTlm.Payload.TlmCapHitCount;
+
+    if (Chan->BacklogCycles < TO_LAB_BACKLOG_CYCLES)
+    {
+        ++Chan->BacklogCycles;
+    }
+
+    if (Chan->BacklogCycles < TO_LAB_BACKLOG_CYCLES)
+    {
+        return;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+    if (Chan->BacklogReported &&
+        OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, Chan->LastBacklogEvent)) < TO_LAB_BACKLOG_EVENT_MSEC)
+    {
+        return;
+    }
+
+    Chan->BacklogReported  = true;
+    Chan->LastBacklogEvent = CurrTime;
+
+    CFE_EVS_SendEvent(TO_LAB_BACKLOG_ERR_EID, CFE_EVS_EventType_ERROR,
+                      "TO telemetry backlog on channel %u: queued hi/lo %u/%u, SB peak depth hi/lo %u/%u",
+                      (unsigned int)Chan->ChannelIdx, (unsigned int)Chan->PipeHighWater[TO_LAB_PRIO_HIGH],
+                      (unsigned int)Chan->PipeHighWater[TO_LAB_PRIO_LOW],
+                      (unsigned int)Chan->SbPeakDepth[TO_LAB_PRIO_HIGH],
+                      (unsigned int)Chan->SbPeakDepth[TO_LAB_PRIO_LOW]);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_adapt_drain_budget() -- Size a channel's next drain pass */
+/*                                                                 */
+/* Found is the number of packets the pass took from the channel's */
+/* pipes.  A pass that stopped with packets still queued doubles   */
+/* the budget so a burst is worked off in a few cycles, unless the */
+/* time slice stopped it, when more budget would not help.  Once   */
+/* the backlog clears, the budget halves, but not below twice the  */
+/* packets found, so it follows a steady load without oscillating. */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_adapt_drain_budget(TO_LAB_Channel_t *Chan, uint32 Found, bool CapHit, bool SliceHit)
+{
+    uint32 Floor;
+
+    if (CapHit)
+    {
+        if (!SliceHit)
+        {
+            Chan->DrainBudget *= 2;
+        }
+    }
+    else
+    {
+        Floor = 2 * Found;
+        if (Floor < Chan->DrainBudget / 2)
+        {
+            Floor = Chan->DrainBudget / 2;
+        }
+
+        Chan->DrainBudget = Floor < Chan->DrainBudget ? Floor : Chan->DrainBudget;
+    }
+
+    if (Chan->DrainBudget > TO_LAB_DRAIN_BUDGET_MAX)
+    {
+        Chan->DrainBudget = TO_LAB_DRAIN_BUDGET_MAX;
+    }
+    if (Chan->DrainBudget < TO_LAB_MAX_TLM_PKTS)
+    {
+        Chan->DrainBudget = TO_LAB_MAX_TLM_PKTS;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_pend_telemetry() -- Event-driven telemetry forwarding    */
+/*                                                                 */
+/* Pends on the wake pipe, which receives a copy of every stream   */
+/* the channels subscribe to, and drains every telemetry pipe each */
+/* time it wakes, until TO_LAB_TASK_MSEC has elapsed.  The caller  */
+/* then services the command pipe on a bounded schedule.  The      */
+/* drains are accounted for once, at the end of the cycle.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_pend_telemetry(void)
+{
+    TO_LAB_DrainStats_t Stats;
+    OS_time_t           StartTime;
+    OS_time_t           CurrTime;
+    int64               ElapsedMsec;
+    int32               TimeoutMsec;
+    CFE_Status_t        CfeStatus;
+    CFE_SB_Buffer_t    *SBBufPtr;
+    uint16              i;
+
+    memset(&Stats, 0, sizeof(Stats));
+
+    OS_GetLocalTime(&StartTime);
+    ElapsedMsec = 0;
+
+    /* Whatever the last cycle left queued goes first */
+    TO_LAB_drain_channels(&Stats);
+
+    do
+    {
+        /* Wake up in time to flush a partially filled batch */
+        TimeoutMsec = (int32)(TO_LAB_TASK_MSEC - ElapsedMsec);
+        for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+        {
+            if (TimeoutMsec > TO_LAB_OutputMsecToDeadline(&TO_LAB_Global.Channel[i]))
+            {
+                TimeoutMsec = TO_LAB_OutputMsecToDeadline(&TO_LAB_Global.Channel[i]);
+            }
+        }
+
+        CFE_ES_PerfLogExit(TO_LAB_MAIN_TASK_PERF_ID);
+
+        CfeStatus = CFE_SB_ReceiveBuffer(&SBBufPtr, TO_LAB_Global.Wake_pipe, TimeoutMsec);
+
+        CFE_ES_PerfLogEntry(TO_LAB_MAIN_TASK_PERF_ID);
+
+        /* The copies only signal arrival, the packets are taken from the channel pipes */
+        if (CfeStatus == CFE_SUCCESS)
+        {
+            while (CFE_SB_ReceiveBuffer(&SBBufPtr, TO_LAB_Global.Wake_pipe, CFE_SB_POLL) == CFE_SUCCESS)
+            {
+            }
+        }
+
+        TO_LAB_drain_channels(&Stats);
+
+        OS_GetLocalTime(&CurrTime);
+        ElapsedMsec = OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, StartTime));
+
+        if (CfeStatus != CFE_SUCCESS && CfeStatus != CFE_SB_TIME_OUT)
+        {
+            /* Pipe error -- do not spin, wait out the rest of the cycle */
+            if (ElapsedMsec >= 0 && ElapsedMsec < TO_LAB_TASK_MSEC)
+            {
+                OS_TaskDelay((uint32)(TO_LAB_TASK_MSEC - ElapsedMsec));
+            }
+            break;
+        }
+    } while (ElapsedMsec >= 0 && ElapsedMsec < TO_LAB_TASK_MSEC);
+
+    TO_LAB_drain_accounting(&Stats);
 }
 
 /************************/
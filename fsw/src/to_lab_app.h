@@ -28,10 +28,20 @@
 #include "osapi.h"
 #include "cfe.h"
 
+#include "cfe_sb_msg.h"
+
 #include "to_lab_mission_cfg.h"
 #include "to_lab_platform_cfg.h"
 #include "to_lab_cmds.h"
+#include "to_lab_delta.h"
 #include "to_lab_dispatch.h"
+#include "to_lab_encode_pool.h"
+#include "to_lab_histogram.h"
+#include "to_lab_output.h"
+#include "to_lab_sender.h"
+#include "to_lab_slab.h"
+#include "to_lab_streams.h"
+#include "to_lab_tcp.h"
 #include "to_lab_msg.h"
 #include "to_lab_tbl.h"
 
@@ -44,30 +54,76 @@
  */
 typedef struct
 {
-    CFE_SB_PipeId_t Tlm_pipe;
     CFE_SB_PipeId_t Cmd_pipe;
-    osal_id_t       TLMsockid;
-    bool            downlink_on;
-    char            tlm_dest_IP[17];
-    bool            suppress_sendto;
+    CFE_SB_PipeId_t Wake_pipe; /**< Every subscribed stream, in event-driven mode */
+
+    TO_LAB_Channel_t Channel[TO_LAB_MAX_CHANNELS];
+    uint16           NextChannel; /**< Channel drained first on the next cycle */
 
     TO_LAB_HkTlm_t        HkTlm;
     TO_LAB_DataTypesTlm_t DataTypesTlm;
+    TO_LAB_StreamTlm_t    StreamTlm;
+    TO_LAB_HkExtTlm_t     HkExtTlm; /**< Histograms accumulate here between HK requests */
+
+    TO_LAB_StreamTable_t Streams; /**< Per-stream state, indexed by MsgId */
+
+    TO_LAB_Sender_t     Sender;     /**< Used when TO_LAB_SENDER_TASK_ENABLE is set */
+    TO_LAB_EncodePool_t EncodePool; /**< Used when TO_LAB_ENCODE_WORKERS is non-zero */
+    TO_LAB_Slab_t       Slab;       /**< Buffers for packets queued to the encode workers */
+    TO_LAB_DeltaCache_t Delta;      /**< Reference copies for delta encoded streams */
+
+    /* Scratch space for packets the main task encodes itself */
+    uint8 EncodeBuffer[CFE_MISSION_SB_MAX_SB_MSG_SIZE];
 
     TO_LAB_Subs_t *  SubsTblPtr;
     CFE_TBL_Handle_t SubsTblHandle;
 
+    uint64 LatencySumMsec; /**< Sum of packet timestamp to forwarding latency since last HK */
+    uint32 LatencyCount;   /**< Number of packets in LatencySumMsec */
+
 } TO_LAB_GlobalData_t;
 
+/**
+ * Packets drained from the telemetry pipes over one cycle
+ */
+typedef struct
+{
+    uint32 PktCount[TO_LAB_MAX_CHANNELS];                   /**< Packets received, counted against DrainBudget */
+    uint16 PipeCount[TO_LAB_MAX_CHANNELS][TO_LAB_NUM_PRIO]; /**< Packets received, by pipe */
+    bool   CapHit[TO_LAB_MAX_CHANNELS];                     /**< Stopped with packets still queued */
+    bool   SliceHit;                                        /**< A drain ran out of time */
+} TO_LAB_DrainStats_t;
+
 /************************************************************************
  * Function Prototypes
  ************************************************************************/
 
-void  TO_LAB_AppMain(void);
-void  TO_LAB_openTLM(void);
-int32 TO_LAB_init(void);
-void  TO_LAB_process_commands(void);
-void  TO_LAB_forward_telemetry(void);
+void            TO_LAB_AppMain(void);
+void            TO_LAB_openTLM(TO_LAB_Channel_t *Chan);
+void            TO_LAB_closeTLM(TO_LAB_Channel_t *Chan);
+int32           TO_LAB_init(void);
+int32           TO_LAB_init_channel(uint16 ChannelIdx);
+int32           TO_LAB_resolve_dest(TO_LAB_Channel_t *Chan);
+CFE_SB_PipeId_t TO_LAB_select_pipe(const TO_LAB_Channel_t *Chan, CFE_SB_Qos_t Flags);
+void            TO_LAB_note_subscribed(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx, CFE_SB_Qos_t Flags);
+void            TO_LAB_note_unsubscribed(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx);
+CFE_SB_PipeId_t TO_LAB_subscribed_pipe(const TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t MsgId);
+void            TO_LAB_process_commands(void);
+bool            TO_LAB_forward_from_pipe(TO_LAB_Channel_t *Chan, uint16 Prio);
+void            TO_LAB_forward_telemetry(void);
+void            TO_LAB_drain_channels(TO_LAB_DrainStats_t *Stats);
+void            TO_LAB_drain_accounting(const TO_LAB_DrainStats_t *Stats);
+void            TO_LAB_wake_subscribe(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx);
+void            TO_LAB_wake_unsubscribe(CFE_SB_MsgId_t MsgId, uint16 ChannelIdx);
+void            TO_LAB_pend_telemetry(void);
+void            TO_LAB_output_packet(TO_LAB_Channel_t *Chan, const CFE_SB_Buffer_t *SBBufPtr);
+void            TO_LAB_output_encoded(TO_LAB_Channel_t *Chan, TO_LAB_Stream_t *Stream, CFE_SB_MsgId_t MsgId,
+                                      uint32 PayloadHash, CFE_TIME_SysTime_t PktTime, CFE_Status_t EncodeStatus,
+                                      const void *NetBufPtr, size_t NetBufSize);
+void            TO_LAB_record_latency(CFE_TIME_SysTime_t PktTime);
+void            TO_LAB_record_sb_stats(const CFE_SB_StatsTlm_t *StatsPtr);
+void            TO_LAB_check_backlog(TO_LAB_Channel_t *Chan, bool CapHit);
+void            TO_LAB_adapt_drain_budget(TO_LAB_Channel_t *Chan, uint32 Found, bool CapHit, bool SliceHit);
 
 /******************************************************************************/
 
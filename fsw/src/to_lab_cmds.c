@@ -26,11 +26,146 @@
 
 #include "to_lab_app.h"
 #include "to_lab_cmds.h"
+#include "to_lab_encode.h"
 #include "to_lab_msg.h"
 #include "to_lab_eventids.h"
 #include "to_lab_msgids.h"
 #include "to_lab_version.h"
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_GetChannel() -- Validate a commanded channel number      */
+/*                                                                 */
+/* Returns NULL (and reports the error) if out of range            */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static TO_LAB_Channel_t *TO_LAB_GetChannel(uint8 ChannelIdx)
+{
+    if (ChannelIdx >= TO_LAB_MAX_CHANNELS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_CHANNEL_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO invalid channel %u, max %u",
+                          __LINE__, (unsigned int)ChannelIdx, (unsigned int)(TO_LAB_MAX_CHANNELS - 1));
+        ++TO_LAB_Global.HkTlm.Payload.CommandErrorCounter;
+        return NULL;
+    }
+
+    return &TO_LAB_Global.Channel[ChannelIdx];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EnableChannel() -- Enable output on one channel          */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_EnableChannel(TO_LAB_Channel_t *Chan, const char *dest_IP, size_t dest_IP_size, uint16 dest_port,
+                                 uint8 Transport)
+{
+    /* Keep the sender task off the socket until the change is complete */
+    TO_LAB_SenderQuiesce(Chan);
+    TO_LAB_OutputRetryDiscard(Chan);
+
+    /* A connection, and a socket's type, cannot be changed, so start over with a new one */
+    if (Chan->downlink_on &&
+        (Chan->Connected || Chan->Transport == TO_LAB_TRANSPORT_TCP || Chan->Transport != Transport))
+    {
+        /* Datagrams still batched or held cannot be framed onto a stream, or the reverse */
+        if (Chan->Transport != Transport)
+        {
+            TO_LAB_OutputDiscard(Chan);
+        }
+
+        TO_LAB_closeTLM(Chan);
+        Chan->downlink_on = false;
+    }
+
+    (void)CFE_SB_MessageStringGet(Chan->tlm_dest_IP, dest_IP, "", sizeof(Chan->tlm_dest_IP), dest_IP_size);
+    Chan->tlm_dest_port   = dest_port;
+    Chan->Transport       = Transport;
+    Chan->suppress_sendto = false;
+
+    /* The ground may be starting a new session, give it a fresh history */
+    Chan->Compress.ResetPending = true;
+    TO_LAB_DeltaResetChannel(Chan->ChannelIdx);
+    CFE_EVS_SendEvent(TO_LAB_TLMOUTENA_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "TO telemetry output enabled for IP %s port %u%s, channel %u", Chan->tlm_dest_IP,
+                      (unsigned int)Chan->tlm_dest_port, Transport == TO_LAB_TRANSPORT_TCP ? " (TCP)" : "",
+                      (unsigned int)Chan->ChannelIdx);
+
+    if (!Chan->downlink_on) /* Then turn it on, otherwise we will just switch destination addresses*/
+    {
+        /* A stream socket is opened by each connect attempt */
+        if (Transport == TO_LAB_TRANSPORT_UDP)
+        {
+            TO_LAB_openTLM(Chan);
+        }
+        Chan->downlink_on = true;
+    }
+
+    /* Nothing goes out until the destination is usable */
+    if (TO_LAB_resolve_dest(Chan) != OS_SUCCESS)
+    {
+        Chan->suppress_sendto = true;
+    }
+    else if (Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        TO_LAB_TcpConnect(Chan);
+    }
+
+    TO_LAB_SenderUnlock();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SubscribeChannel() -- Add a stream to one channel        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_SubscribeChannel(TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t Stream, CFE_SB_Qos_t Flags, uint16 BufLimit)
+{
+    int32 status;
+
+    status = CFE_SB_SubscribeEx(Stream, TO_LAB_select_pipe(Chan, Flags), Flags, BufLimit);
+    TO_LAB_EncodeInvalidateCache();
+
+    if (status != CFE_SUCCESS)
+        CFE_EVS_SendEvent(TO_LAB_ADDPKT_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't subscribe 0x%x status %i",
+                          __LINE__, (unsigned int)CFE_SB_MsgIdToValue(Stream), (int)status);
+    else
+    {
+        /* Streams added by command are not decimated, but are still tracked */
+        TO_LAB_note_subscribed(Stream, Chan->ChannelIdx, Flags);
+        TO_LAB_wake_subscribe(Stream, Chan->ChannelIdx);
+        CFE_EVS_SendEvent(TO_LAB_ADDPKT_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "L%d TO AddPkt 0x%x, QoS %d.%d, limit %d, channel %u", __LINE__,
+                          (unsigned int)CFE_SB_MsgIdToValue(Stream), Flags.Priority, Flags.Reliability, BufLimit,
+                          (unsigned int)Chan->ChannelIdx);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_UnsubscribeChannel() -- Remove a stream from one channel */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_UnsubscribeChannel(TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t Stream)
+{
+    int32 status;
+
+    status = CFE_SB_Unsubscribe(Stream, TO_LAB_subscribed_pipe(Chan, Stream));
+    TO_LAB_EncodeInvalidateCache();
+
+    if (status != CFE_SUCCESS)
+        CFE_EVS_SendEvent(TO_LAB_REMOVEPKT_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't Unsubscribe to Stream 0x%x, status %i", __LINE__,
+                          (unsigned int)CFE_SB_MsgIdToValue(Stream), (int)status);
+    else
+    {
+        TO_LAB_wake_unsubscribe(Stream, Chan->ChannelIdx);
+        TO_LAB_note_unsubscribed(Stream, Chan->ChannelIdx);
+        CFE_EVS_SendEvent(TO_LAB_REMOVEPKT_INF_EID, CFE_EVS_EventType_INFORMATION, "L%d TO RemovePkt 0x%x, channel %u",
+                          __LINE__, (unsigned int)CFE_SB_MsgIdToValue(Stream), (unsigned int)Chan->ChannelIdx);
+    }
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* TO_LAB_EnableOutput() -- TLM output enabled                     */
@@ -40,19 +175,76 @@ CFE_Status_t TO_LAB_EnableOutputCmd(const TO_LAB_EnableOutputCmd_t *data)
 {
     const TO_LAB_EnableOutput_Payload_t *pCmd = &data->Payload;
 
-    (void)CFE_SB_MessageStringGet(TO_LAB_Global.tlm_dest_IP, pCmd->dest_IP, "", sizeof(TO_LAB_Global.tlm_dest_IP),
-                                  sizeof(pCmd->dest_IP));
-    TO_LAB_Global.suppress_sendto = false;
-    CFE_EVS_SendEvent(TO_LAB_TLMOUTENA_INF_EID, CFE_EVS_EventType_INFORMATION, "TO telemetry output enabled for IP %s",
-                      TO_LAB_Global.tlm_dest_IP);
+    TO_LAB_EnableChannel(&TO_LAB_Global.Channel[0], pCmd->dest_IP, sizeof(pCmd->dest_IP), TO_LAB_TLM_PORT,
+                         TO_LAB_TRANSPORT_UDP);
+
+    ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EnableChannelOutput() -- TLM output enabled on a channel */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_EnableChannelOutputCmd(const TO_LAB_EnableChannelOutputCmd_t *data)
+{
+    const TO_LAB_EnableChannelOutput_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                           *Chan;
+    uint16                                      dest_port;
 
-    if (!TO_LAB_Global.downlink_on) /* Then turn it on, otherwise we will just switch destination addresses*/
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan != NULL && pCmd->Transport != TO_LAB_TRANSPORT_UDP &&
+        (pCmd->Transport != TO_LAB_TRANSPORT_TCP || !TO_LAB_TCP_ENABLE))
+    {
+        CFE_EVS_SendEvent(TO_LAB_TLMOUTDEST_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO transport %u not supported, channel %u", __LINE__, (unsigned int)pCmd->Transport,
+                          (unsigned int)Chan->ChannelIdx);
+        ++TO_LAB_Global.HkTlm.Payload.CommandErrorCounter;
+    }
+    else if (Chan != NULL)
     {
-        TO_LAB_openTLM();
-        TO_LAB_Global.downlink_on = true;
+        dest_port = pCmd->dest_port;
+        if (dest_port == 0)
+        {
+            dest_port = TO_LAB_TLM_PORT + Chan->ChannelIdx;
+        }
+
+        TO_LAB_EnableChannel(Chan, pCmd->dest_IP, sizeof(pCmd->dest_IP), dest_port, pCmd->Transport);
+        ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    }
+
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_DisableChannelOutput() -- TLM output disabled on channel */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_DisableChannelOutputCmd(const TO_LAB_DisableChannelOutputCmd_t *data)
+{
+    const TO_LAB_DisableChannelOutput_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                            *Chan;
+
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan != NULL)
+    {
+        if (Chan->downlink_on)
+        {
+            TO_LAB_OutputDiscard(Chan);
+            TO_LAB_SenderQuiesce(Chan);
+            TO_LAB_OutputRetryDiscard(Chan);
+            TO_LAB_closeTLM(Chan);
+            Chan->downlink_on = false;
+            TO_LAB_SenderUnlock();
+        }
+
+        CFE_EVS_SendEvent(TO_LAB_TLMOUTDIS_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "TO telemetry output disabled, channel %u", (unsigned int)Chan->ChannelIdx);
+        ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
     }
 
-    ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
     return CFE_SUCCESS;
 }
 
@@ -81,8 +273,73 @@ CFE_Status_t TO_LAB_NoopCmd(const TO_LAB_NoopCmd_t *data)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 CFE_Status_t TO_LAB_ResetCountersCmd(const TO_LAB_ResetCountersCmd_t *data)
 {
+    TO_LAB_Stream_t *Stream;
+    uint16           i;
+
+    /* The sender task updates some of these */
+    TO_LAB_SenderLock();
+
     TO_LAB_Global.HkTlm.Payload.CommandErrorCounter = 0;
     TO_LAB_Global.HkTlm.Payload.CommandCounter      = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmForwardedCount   = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmDatagramCount    = 0;
+    TO_LAB_Global.HkTlm.Payload.EncodeCacheHits     = 0;
+    TO_LAB_Global.HkTlm.Payload.EncodeCacheMisses   = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmLatencyMaxMsec   = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmDeferredCount    = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmDeferDropCount   = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmCapHitCount      = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmSliceHitCount    = 0;
+    TO_LAB_Global.HkTlm.Payload.SendStallCount      = 0;
+    TO_LAB_Global.HkTlm.Payload.SendRingDropCount   = 0;
+    TO_LAB_Global.Sender.HighWater                  = 0;
+    TO_LAB_Global.Sender.StaleDropCount             = 0;
+    TO_LAB_Global.EncodePool.HighWater              = 0;
+    TO_LAB_Global.Slab.HighWater                    = 0;
+    TO_LAB_Global.Slab.AllocFailCount               = 0;
+    TO_LAB_Global.HkTlm.Payload.CompressInBytes     = 0;
+    TO_LAB_Global.HkTlm.Payload.CompressOutBytes    = 0;
+    TO_LAB_Global.HkTlm.Payload.CompressUsec        = 0;
+    TO_LAB_Global.HkTlm.Payload.DeltaInBytes        = 0;
+    TO_LAB_Global.HkTlm.Payload.DeltaOutBytes       = 0;
+    TO_LAB_Global.HkTlm.Payload.DeltaKeyframeCount  = 0;
+    TO_LAB_Global.HkTlm.Payload.DeltaEvictCount     = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmSkippedCount     = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmSkippedBytes     = 0;
+    TO_LAB_Global.HkTlm.Payload.SendTransientErrors = 0;
+    TO_LAB_Global.HkTlm.Payload.SendFatalErrors     = 0;
+    TO_LAB_Global.HkTlm.Payload.SendRetryCount      = 0;
+    TO_LAB_Global.HkTlm.Payload.SendRetryDropCount  = 0;
+    TO_LAB_Global.HkTlm.Payload.SendWouldBlockCount = 0;
+    TO_LAB_Global.HkTlm.Payload.TcpConnectCount     = 0;
+    TO_LAB_Global.HkTlm.Payload.TcpDisconnectCount  = 0;
+    TO_LAB_Global.HkTlm.Payload.TcpBytesSent        = 0;
+    TO_LAB_Global.HkTlm.Payload.TcpPartialWrites    = 0;
+    TO_LAB_Global.HkTlm.Payload.TcpDroppedBytes     = 0;
+    TO_LAB_Global.LatencySumMsec                    = 0;
+    TO_LAB_Global.LatencyCount                      = 0;
+    memset(&TO_LAB_Global.HkExtTlm.Payload, 0, sizeof(TO_LAB_Global.HkExtTlm.Payload));
+
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        TO_LAB_Global.Channel[i].HoldRing.HighWater = 0;
+        memset(TO_LAB_Global.Channel[i].PipeHighWater, 0, sizeof(TO_LAB_Global.Channel[i].PipeHighWater));
+        memset(TO_LAB_Global.Channel[i].SbPeakDepth, 0, sizeof(TO_LAB_Global.Channel[i].SbPeakDepth));
+    }
+
+    for (i = 0; i < TO_LAB_Global.Streams.NumStreams; i++)
+    {
+        Stream = &TO_LAB_Global.Streams.Stream[i];
+
+        memset(Stream->DecimatedCount, 0, sizeof(Stream->DecimatedCount));
+        Stream->SkippedCount     = 0;
+        Stream->ForwardedCount   = 0;
+        Stream->ByteCount        = 0;
+        Stream->EncodeErrorCount = 0;
+        Stream->SendErrorCount   = 0;
+    }
+
+    TO_LAB_SenderUnlock();
 
     CFE_EVS_SendEvent(TO_LAB_RESET_INF_EID, CFE_EVS_EventType_INFORMATION, "Reset counters command");
 
@@ -147,11 +404,126 @@ CFE_Status_t TO_LAB_SendDataTypesCmd(const TO_LAB_SendDataTypesCmd_t *data)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 CFE_Status_t TO_LAB_SendHkCmd(const TO_LAB_SendHkCmd_t *data)
 {
+    TO_LAB_Channel_t *Chan;
+    uint16            i;
+    uint16            Prio;
+
+    /* The sender task updates the send counters and histograms under this lock */
+    TO_LAB_SenderLock();
+
+    TO_LAB_Global.HkTlm.Payload.SendRingDropCount += TO_LAB_Global.Sender.StaleDropCount;
+    TO_LAB_Global.Sender.StaleDropCount = 0;
+
+    if (TO_LAB_Global.LatencyCount != 0)
+    {
+        TO_LAB_Global.HkTlm.Payload.TlmLatencyAvgMsec =
+            (uint32)(TO_LAB_Global.LatencySumMsec / TO_LAB_Global.LatencyCount);
+    }
+    else
+    {
+        TO_LAB_Global.HkTlm.Payload.TlmLatencyAvgMsec = 0;
+    }
+
+    TO_LAB_Global.HkTlm.Payload.HeldBufCount     = 0;
+    TO_LAB_Global.HkTlm.Payload.HeldBufHighWater = 0;
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        TO_LAB_Global.HkTlm.Payload.HeldBufCount += (uint16)TO_LAB_Global.Channel[i].HoldRing.Count;
+        if (TO_LAB_Global.Channel[i].HoldRing.HighWater > TO_LAB_Global.HkTlm.Payload.HeldBufHighWater)
+        {
+            TO_LAB_Global.HkTlm.Payload.HeldBufHighWater = (uint16)TO_LAB_Global.Channel[i].HoldRing.HighWater;
+        }
+    }
+
+    TO_LAB_Global.HkTlm.Payload.SendRingCount     = TO_LAB_SenderQueued();
+    TO_LAB_Global.HkTlm.Payload.SendRingHighWater = TO_LAB_Global.Sender.HighWater;
+
+    TO_LAB_Global.HkTlm.Payload.EncodeQueueHighWater = TO_LAB_Global.EncodePool.HighWater;
+    TO_LAB_Global.HkTlm.Payload.SlabInUse            = TO_LAB_Global.Slab.InUse;
+    TO_LAB_Global.HkTlm.Payload.SlabHighWater        = TO_LAB_Global.Slab.HighWater;
+    TO_LAB_Global.HkTlm.Payload.SlabAllocFailCount   = TO_LAB_Global.Slab.AllocFailCount;
+
+    TO_LAB_Global.HkTlm.Payload.TlmPipeHighWater = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmSbPeakDepth   = 0;
+    TO_LAB_Global.HkTlm.Payload.TlmDrainBudget   = 0;
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        Chan = &TO_LAB_Global.Channel[i];
+
+        if (Chan->DrainBudget > TO_LAB_Global.HkTlm.Payload.TlmDrainBudget)
+        {
+            TO_LAB_Global.HkTlm.Payload.TlmDrainBudget = (uint16)Chan->DrainBudget;
+        }
+
+        for (Prio = 0; Prio < TO_LAB_NUM_PRIO; Prio++)
+        {
+            if (Chan->PipeHighWater[Prio] > TO_LAB_Global.HkTlm.Payload.TlmPipeHighWater)
+            {
+                TO_LAB_Global.HkTlm.Payload.TlmPipeHighWater = Chan->PipeHighWater[Prio];
+            }
+            if (Chan->SbPeakDepth[Prio] > TO_LAB_Global.HkTlm.Payload.TlmSbPeakDepth)
+            {
+                TO_LAB_Global.HkTlm.Payload.TlmSbPeakDepth = Chan->SbPeakDepth[Prio];
+            }
+        }
+    }
+
     CFE_SB_TimeStampMsg(CFE_MSG_PTR(TO_LAB_Global.HkTlm.TelemetryHeader));
     CFE_SB_TransmitMsg(CFE_MSG_PTR(TO_LAB_Global.HkTlm.TelemetryHeader), true);
+
+    TO_LAB_SendStreamTlm();
+
+    CFE_SB_TimeStampMsg(CFE_MSG_PTR(TO_LAB_Global.HkExtTlm.TelemetryHeader));
+    CFE_SB_TransmitMsg(CFE_MSG_PTR(TO_LAB_Global.HkExtTlm.TelemetryHeader), true);
+
+    /* Latency statistics and histograms cover one HK interval */
+    TO_LAB_Global.HkTlm.Payload.TlmLatencyMaxMsec = 0;
+    TO_LAB_Global.LatencySumMsec                  = 0;
+    TO_LAB_Global.LatencyCount                    = 0;
+    memset(&TO_LAB_Global.HkExtTlm.Payload, 0, sizeof(TO_LAB_Global.HkExtTlm.Payload));
+
+    TO_LAB_SenderUnlock();
+
     return CFE_SUCCESS;
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SendStreamTlm() -- Send per-stream counters              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SendStreamTlm(void)
+{
+    TO_LAB_StreamTlm_Payload_t *Payload = &TO_LAB_Global.StreamTlm.Payload;
+    const TO_LAB_Stream_t      *Stream;
+    uint16                      i;
+    uint16                      ChannelIdx;
+
+    memset(Payload, 0, sizeof(*Payload));
+
+    Payload->NumStreams = TO_LAB_Global.Streams.NumStreams;
+    for (i = 0; i < TO_LAB_Global.Streams.NumStreams; i++)
+    {
+        Stream = &TO_LAB_Global.Streams.Stream[i];
+
+        Payload->Stream[i].MsgId = Stream->MsgId;
+        for (ChannelIdx = 0; ChannelIdx < TO_LAB_MAX_CHANNELS; ChannelIdx++)
+        {
+            Payload->Stream[i].DecimatedCount[ChannelIdx] = Stream->DecimatedCount[ChannelIdx];
+        }
+
+        Payload->Stream[i].SkippedCount     = Stream->SkippedCount;
+        Payload->Stream[i].ForwardedCount   = Stream->ForwardedCount;
+        Payload->Stream[i].ByteCount        = Stream->ByteCount;
+        Payload->Stream[i].EncodeErrorCount = Stream->EncodeErrorCount;
+        Payload->Stream[i].SendErrorCount   = Stream->SendErrorCount;
+        Payload->Stream[i].LastSeenTime     = Stream->LastSeenTime;
+    }
+
+    CFE_SB_TimeStampMsg(CFE_MSG_PTR(TO_LAB_Global.StreamTlm.TelemetryHeader));
+    CFE_SB_TransmitMsg(CFE_MSG_PTR(TO_LAB_Global.StreamTlm.TelemetryHeader), true);
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* TO_LAB_AddPacket() -- Add packets                               */
@@ -160,23 +532,119 @@ CFE_Status_t TO_LAB_SendHkCmd(const TO_LAB_SendHkCmd_t *data)
 CFE_Status_t TO_LAB_AddPacketCmd(const TO_LAB_AddPacketCmd_t *data)
 {
     const TO_LAB_AddPacket_Payload_t *pCmd = &data->Payload;
-    int32                             status;
 
-    status = CFE_SB_SubscribeEx(pCmd->Stream, TO_LAB_Global.Tlm_pipe, pCmd->Flags, pCmd->BufLimit);
+    TO_LAB_SubscribeChannel(&TO_LAB_Global.Channel[0], pCmd->Stream, pCmd->Flags, pCmd->BufLimit);
 
-    if (status != CFE_SUCCESS)
-        CFE_EVS_SendEvent(TO_LAB_ADDPKT_ERR_EID, CFE_EVS_EventType_ERROR, "L%d TO Can't subscribe 0x%x status %i",
-                          __LINE__, (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream), (int)status);
+    ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SetRateLimit() -- Set a channel or stream rate limit     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_SetRateLimitCmd(const TO_LAB_SetRateLimitCmd_t *data)
+{
+    const TO_LAB_SetRateLimit_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                    *Chan;
+    int32                                status;
+
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan == NULL)
+    {
+        return CFE_SUCCESS;
+    }
+
+    if (!CFE_SB_IsValidMsgId(pCmd->Stream))
+    {
+        TO_LAB_RateLimitSetChannel(&Chan->RateLimit, pCmd->BytesPerSec, pCmd->PktsPerSec);
+
+        CFE_EVS_SendEvent(TO_LAB_RATELIMIT_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "TO rate limit %lu bytes/s, %lu pkts/s, channel %u", (unsigned long)pCmd->BytesPerSec,
+                          (unsigned long)pCmd->PktsPerSec, (unsigned int)Chan->ChannelIdx);
+    }
     else
-        CFE_EVS_SendEvent(TO_LAB_ADDPKT_INF_EID, CFE_EVS_EventType_INFORMATION,
-                          "L%d TO AddPkt 0x%x, QoS %d.%d, limit %d", __LINE__,
-                          (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream), pCmd->Flags.Priority,
-                          pCmd->Flags.Reliability, pCmd->BufLimit);
+    {
+        status = TO_LAB_RateLimitSetStream(&Chan->RateLimit, pCmd->Stream, pCmd->BytesPerSec, pCmd->PktsPerSec);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_RATELIMIT_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO Can't limit stream 0x%x, all %u stream limits in use", __LINE__,
+                              (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream), (unsigned int)TO_LAB_MAX_SUBSCRIPTIONS);
+            ++TO_LAB_Global.HkTlm.Payload.CommandErrorCounter;
+            return CFE_SUCCESS;
+        }
+
+        CFE_EVS_SendEvent(TO_LAB_RATELIMIT_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "TO rate limit 0x%x to %lu bytes/s, %lu pkts/s, channel %u",
+                          (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream), (unsigned long)pCmd->BytesPerSec,
+                          (unsigned long)pCmd->PktsPerSec, (unsigned int)Chan->ChannelIdx);
+    }
+
+    ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SetCompression() -- Set a channel's compression          */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_SetCompressionCmd(const TO_LAB_SetCompressionCmd_t *data)
+{
+    const TO_LAB_SetCompression_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                      *Chan;
+
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan == NULL)
+    {
+        return CFE_SUCCESS;
+    }
+
+    if (pCmd->Enable != 0 && !TO_LAB_COMPRESS_ENABLE)
+    {
+        CFE_EVS_SendEvent(TO_LAB_COMPRESS_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO compression is not built in, channel %u", __LINE__, (unsigned int)Chan->ChannelIdx);
+        ++TO_LAB_Global.HkTlm.Payload.CommandErrorCounter;
+        return CFE_SUCCESS;
+    }
+
+    /* A partial batch goes out under the old setting */
+    TO_LAB_OutputFlush(Chan);
+
+    Chan->Compress.Enabled       = (pCmd->Enable != 0);
+    Chan->Compress.ResetInterval = pCmd->ResetInterval;
+    Chan->Compress.ResetPending  = true;
+
+    CFE_EVS_SendEvent(TO_LAB_COMPRESS_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "TO compression %s, reset every %u datagrams, channel %u", Chan->Compress.Enabled ? "on" : "off",
+                      (unsigned int)Chan->Compress.ResetInterval, (unsigned int)Chan->ChannelIdx);
 
     ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
     return CFE_SUCCESS;
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_AddChannelPacket() -- Add packets to a channel           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_AddChannelPacketCmd(const TO_LAB_AddChannelPacketCmd_t *data)
+{
+    const TO_LAB_AddChannelPacket_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                        *Chan;
+
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan != NULL)
+    {
+        TO_LAB_SubscribeChannel(Chan, pCmd->Stream, pCmd->Flags, pCmd->BufLimit);
+        ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    }
+
+    return CFE_SUCCESS;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* TO_LAB_RemovePacket() -- Remove Packet                          */
@@ -185,20 +653,56 @@ CFE_Status_t TO_LAB_AddPacketCmd(const TO_LAB_AddPacketCmd_t *data)
 CFE_Status_t TO_LAB_RemovePacketCmd(const TO_LAB_RemovePacketCmd_t *data)
 {
     const TO_LAB_RemovePacket_Payload_t *pCmd = &data->Payload;
-    int32                                status;
 
-    status = CFE_SB_Unsubscribe(pCmd->Stream, TO_LAB_Global.Tlm_pipe);
-    if (status != CFE_SUCCESS)
-        CFE_EVS_SendEvent(TO_LAB_REMOVEPKT_ERR_EID, CFE_EVS_EventType_ERROR,
-                          "L%d TO Can't Unsubscribe to Stream 0x%x, status %i", __LINE__,
-                          (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream), (int)status);
-    else
-        CFE_EVS_SendEvent(TO_LAB_REMOVEPKT_INF_EID, CFE_EVS_EventType_INFORMATION, "L%d TO RemovePkt 0x%x", __LINE__,
-                          (unsigned int)CFE_SB_MsgIdToValue(pCmd->Stream));
+    TO_LAB_UnsubscribeChannel(&TO_LAB_Global.Channel[0], pCmd->Stream);
+
     ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
     return CFE_SUCCESS;
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RemoveChannelPacket() -- Remove Packet from a channel    */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+CFE_Status_t TO_LAB_RemoveChannelPacketCmd(const TO_LAB_RemoveChannelPacketCmd_t *data)
+{
+    const TO_LAB_RemoveChannelPacket_Payload_t *pCmd = &data->Payload;
+    TO_LAB_Channel_t                           *Chan;
+
+    Chan = TO_LAB_GetChannel(pCmd->Channel);
+    if (Chan != NULL)
+    {
+        TO_LAB_UnsubscribeChannel(Chan, pCmd->Stream);
+        ++TO_LAB_Global.HkTlm.Payload.CommandCounter;
+    }
+
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RemoveAllUnsubscribe() -- Remove one stream from one     */
+/*                                  channel, for RemoveAll         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_RemoveAllUnsubscribe(TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t Stream)
+{
+    int32 status;
+
+    status = CFE_SB_Unsubscribe(Stream, TO_LAB_subscribed_pipe(Chan, Stream));
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_REMOVEALLPTKS_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't Unsubscribe to stream 0x%x status %i", __LINE__,
+                          (unsigned int)CFE_SB_MsgIdToValue(Stream), (int)status);
+        return;
+    }
+
+    TO_LAB_wake_unsubscribe(Stream, Chan->ChannelIdx);
+    TO_LAB_note_unsubscribed(Stream, Chan->ChannelIdx);
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* TO_LAB_RemoveAll() --  Remove All Packets                       */
@@ -206,24 +710,44 @@ CFE_Status_t TO_LAB_RemovePacketCmd(const TO_LAB_RemovePacketCmd_t *data)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 CFE_Status_t TO_LAB_RemoveAllCmd(const TO_LAB_RemoveAllCmd_t *data)
 {
-    int32         status;
-    int           i;
-    TO_LAB_Sub_t *SubEntry;
+    int              i;
+    uint16           ChannelIdx;
+    TO_LAB_Sub_t    *SubEntry;
+    TO_LAB_Stream_t *Stream;
 
-    SubEntry = TO_LAB_Global.SubsTblPtr->Subs;
-    for (i = 0; i < TO_LAB_MAX_SUBSCRIPTIONS; i++)
+    for (ChannelIdx = 0; ChannelIdx < TO_LAB_MAX_CHANNELS; ChannelIdx++)
     {
-        if (CFE_SB_IsValidMsgId(SubEntry->Stream))
+        /* Every stream subscribed on the channel, from the table or by command */
+        for (i = 0; i < TO_LAB_Global.Streams.NumStreams; i++)
         {
-            status = CFE_SB_Unsubscribe(SubEntry->Stream, TO_LAB_Global.Tlm_pipe);
+            Stream = &TO_LAB_Global.Streams.Stream[i];
+            if (Stream->SubChannels & ((uint32)1 << ChannelIdx))
+            {
+                TO_LAB_RemoveAllUnsubscribe(&TO_LAB_Global.Channel[ChannelIdx], Stream->MsgId);
+            }
+        }
 
-            if (status != CFE_SUCCESS)
-                CFE_EVS_SendEvent(TO_LAB_REMOVEALLPTKS_ERR_EID, CFE_EVS_EventType_ERROR,
-                                  "L%d TO Can't Unsubscribe to stream 0x%x status %i", __LINE__,
-                                  (unsigned int)CFE_SB_MsgIdToValue(SubEntry->Stream), (int)status);
+        /* Table streams the stream table had no room for */
+        SubEntry = TO_LAB_Global.SubsTblPtr->Channel[ChannelIdx].Subs;
+        for (i = 0; i < TO_LAB_MAX_SUBSCRIPTIONS; i++)
+        {
+            if (CFE_SB_MsgId_Equal(SubEntry->Stream, CFE_SB_MSGID_RESERVED))
+            {
+                /* Only process until the end of list marker is found */
+                break;
+            }
+
+            if (TO_LAB_StreamLookup(SubEntry->Stream) == NULL)
+            {
+                TO_LAB_RemoveAllUnsubscribe(&TO_LAB_Global.Channel[ChannelIdx], SubEntry->Stream);
+            }
+
+            ++SubEntry;
         }
     }
 
+    TO_LAB_EncodeInvalidateCache();
+
     CFE_EVS_SendEvent(TO_LAB_REMOVEALLPKTS_INF_EID, CFE_EVS_EventType_INFORMATION,
                       "L%d TO Unsubscribed to all Commands and Telemetry", __LINE__);
 
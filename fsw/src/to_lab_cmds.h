@@ -41,6 +41,14 @@ CFE_Status_t TO_LAB_RemovePacketCmd(const TO_LAB_RemovePacketCmd_t *data);
 CFE_Status_t TO_LAB_ResetCountersCmd(const TO_LAB_ResetCountersCmd_t *data);
 CFE_Status_t TO_LAB_SendDataTypesCmd(const TO_LAB_SendDataTypesCmd_t *data);
 CFE_Status_t TO_LAB_SendHkCmd(const TO_LAB_SendHkCmd_t *data);
+CFE_Status_t TO_LAB_EnableChannelOutputCmd(const TO_LAB_EnableChannelOutputCmd_t *data);
+CFE_Status_t TO_LAB_DisableChannelOutputCmd(const TO_LAB_DisableChannelOutputCmd_t *data);
+CFE_Status_t TO_LAB_AddChannelPacketCmd(const TO_LAB_AddChannelPacketCmd_t *data);
+CFE_Status_t TO_LAB_RemoveChannelPacketCmd(const TO_LAB_RemoveChannelPacketCmd_t *data);
+CFE_Status_t TO_LAB_SetRateLimitCmd(const TO_LAB_SetRateLimitCmd_t *data);
+CFE_Status_t TO_LAB_SetCompressionCmd(const TO_LAB_SetCompressionCmd_t *data);
+
+void TO_LAB_SendStreamTlm(void);
 
 /******************************************************************************/
 
@@ -0,0 +1,281 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the datagram compressor of the TO lab application
+ */
+
+#include <string.h>
+
+#include "to_lab_compress.h"
+
+/* Match offsets are 16 bits, and hash entries hold a position + 1 */
+CompileTimeAssert(sizeof(((TO_LAB_CompressHistory_t *)0)->Data) < 0xFFFF, TO_LAB_CompressWindowTooLarge);
+CompileTimeAssert(TO_LAB_COMPRESS_MAX_INPUT <= TO_LAB_COMPRESS_WINDOW, TO_LAB_CompressInputTooLarge);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_CompressTrimHistory() -- Drop old history if another     */
+/*                                 datagram might not fit after it */
+/*                                                                 */
+/* Shared with the decoder so both sides trim at the same points.  */
+/* Returns the number of bytes dropped from the front.             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint16 TO_LAB_CompressTrimHistory(uint8 *Data, size_t Capacity, uint16 *Size)
+{
+    uint16 Shift = 0;
+
+    if (((size_t)*Size + TO_LAB_COMPRESS_MAX_INPUT) > Capacity)
+    {
+        Shift = *Size - TO_LAB_COMPRESS_WINDOW;
+        memmove(Data, &Data[Shift], TO_LAB_COMPRESS_WINDOW);
+        *Size = TO_LAB_COMPRESS_WINDOW;
+    }
+
+    return Shift;
+}
+
+/*
+ * --------------------------------------------
+ * Hash of the 4 bytes at Ptr
+ * --------------------------------------------
+ */
+static inline uint16 TO_LAB_CompressHash(const uint8 *Ptr)
+{
+    uint32 Word = ((uint32)Ptr[0] << 24) | ((uint32)Ptr[1] << 16) | ((uint32)Ptr[2] << 8) | Ptr[3];
+
+    return (uint16)((Word * 2654435761U) >> (32 - TO_LAB_COMPRESS_HASH_BITS));
+}
+
+/*
+ * --------------------------------------------
+ * Write a length as a nibble overflow: extension bytes of 255, then the rest
+ * --------------------------------------------
+ */
+static bool TO_LAB_CompressPutLength(uint8 *Out, size_t *OutPos, size_t OutLimit, size_t Length)
+{
+    while (Length >= 255)
+    {
+        if (*OutPos >= OutLimit)
+        {
+            return false;
+        }
+        Out[(*OutPos)++] = 255;
+        Length -= 255;
+    }
+
+    if (*OutPos >= OutLimit)
+    {
+        return false;
+    }
+    Out[(*OutPos)++] = (uint8)Length;
+
+    return true;
+}
+
+/*
+ * --------------------------------------------
+ * Write one sequence: literals, then a match unless MatchLen is 0.
+ * Returns false if it does not fit before OutLimit.
+ * --------------------------------------------
+ */
+static bool TO_LAB_CompressPutSequence(uint8 *Out, size_t *OutPos, size_t OutLimit, const uint8 *Literals,
+                                       size_t LitLen, size_t MatchOffset, size_t MatchLen)
+{
+    size_t MatchCode = (MatchLen != 0) ? (MatchLen - TO_LAB_COMPRESS_MIN_MATCH) : 0;
+
+    if (*OutPos >= OutLimit)
+    {
+        return false;
+    }
+    Out[(*OutPos)++] = (uint8)(((LitLen < 15 ? LitLen : 15) << 4) | (MatchCode < 15 ? MatchCode : 15));
+
+    if (LitLen >= 15 && !TO_LAB_CompressPutLength(Out, OutPos, OutLimit, LitLen - 15))
+    {
+        return false;
+    }
+
+    if ((*OutPos + LitLen) > OutLimit)
+    {
+        return false;
+    }
+    memcpy(&Out[*OutPos], Literals, LitLen);
+    *OutPos += LitLen;
+
+    if (MatchLen == 0)
+    {
+        return true;
+    }
+
+    if ((*OutPos + 2) > OutLimit)
+    {
+        return false;
+    }
+    Out[(*OutPos)++] = (uint8)(MatchOffset >> 8);
+    Out[(*OutPos)++] = (uint8)MatchOffset;
+
+    if (MatchCode >= 15 && !TO_LAB_CompressPutLength(Out, OutPos, OutLimit, MatchCode - 15))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * --------------------------------------------
+ * Compress Comp->HistoryData from Start to End into Out.  Returns the body
+ * size, or 0 if it would not be smaller than OutLimit bytes.
+ * --------------------------------------------
+ */
+static size_t TO_LAB_CompressBlock(TO_LAB_Compress_t *Comp, size_t Start, size_t End, uint8 *Out, size_t OutLimit)
+{
+    const uint8 *Data   = Comp->HistoryData;
+    size_t       Pos    = Start;
+    size_t       Anchor = Start;
+    size_t       OutPos = 0;
+    size_t       Cand;
+    size_t       Len;
+    size_t       i;
+    uint16       HashIdx;
+
+    while ((Pos + TO_LAB_COMPRESS_MIN_MATCH) <= End)
+    {
+        HashIdx             = TO_LAB_CompressHash(&Data[Pos]);
+        Cand                = Comp->Hash[HashIdx];
+        Comp->Hash[HashIdx] = Pos + 1;
+
+        if (Cand == 0 || memcmp(&Data[Cand - 1], &Data[Pos], TO_LAB_COMPRESS_MIN_MATCH) != 0)
+        {
+            ++Pos;
+            continue;
+        }
+
+        --Cand;
+        Len = TO_LAB_COMPRESS_MIN_MATCH;
+        while ((Pos + Len) < End && Data[Cand + Len] == Data[Pos + Len])
+        {
+            ++Len;
+        }
+
+        if (!TO_LAB_CompressPutSequence(Out, &OutPos, OutLimit, &Data[Anchor], Pos - Anchor, Pos - Cand, Len))
+        {
+            return 0;
+        }
+
+        /* Later datagrams are most likely to repeat whole runs, so index inside the match too */
+        for (i = Pos + 1; i < (Pos + Len) && (i + TO_LAB_COMPRESS_MIN_MATCH) <= End; ++i)
+        {
+            Comp->Hash[TO_LAB_CompressHash(&Data[i])] = i + 1;
+        }
+
+        Pos += Len;
+        Anchor = Pos;
+    }
+
+    if (!TO_LAB_CompressPutSequence(Out, &OutPos, OutLimit, &Data[Anchor], End - Anchor, 0, 0))
+    {
+        return 0;
+    }
+
+    return OutPos;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_CompressInit() -- Set up one channel's compressor        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_CompressInit(TO_LAB_Compress_t *Comp, bool Enabled, uint16 ResetInterval)
+{
+    Comp->Enabled       = Enabled;
+    Comp->ResetInterval = ResetInterval;
+    Comp->ResetPending  = true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_CompressDatagram() -- Compress one outgoing datagram     */
+/*                                                                 */
+/* Returns the size of the result in Comp->Output, or 0 if the     */
+/* datagram is too large and must be sent as it is.  Every other   */
+/* datagram becomes part of the history, so each result must be    */
+/* sent, in order, or the history reset.                           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t TO_LAB_CompressDatagram(TO_LAB_Compress_t *Comp, const void *DataPtr, size_t DataSize)
+{
+    uint8  Flags = 0;
+    uint16 Shift;
+    size_t Start;
+    size_t BodySize;
+    uint32 i;
+
+    if (!TO_LAB_COMPRESS_ENABLE || DataSize == 0 || DataSize > TO_LAB_COMPRESS_MAX_INPUT)
+    {
+        return 0;
+    }
+
+    if (Comp->ResetPending || (Comp->ResetInterval != 0 && Comp->SinceReset >= Comp->ResetInterval))
+    {
+        Comp->HistorySize = 0;
+        memset(Comp->Hash, 0, sizeof(Comp->Hash));
+        Comp->SinceReset   = 0;
+        Comp->ResetPending = false;
+        Flags |= TO_LAB_COMPRESS_FLAG_RESET;
+    }
+
+    Shift = TO_LAB_CompressTrimHistory(Comp->HistoryData, sizeof(Comp->HistoryData), &Comp->HistorySize);
+    if (Shift != 0)
+    {
+        for (i = 0; i < TO_LAB_COMPRESS_HASH_SIZE; i++)
+        {
+            Comp->Hash[i] = (Comp->Hash[i] > Shift) ? (Comp->Hash[i] - Shift) : 0;
+        }
+    }
+
+    Start = Comp->HistorySize;
+    memcpy(&Comp->HistoryData[Start], DataPtr, DataSize);
+
+    /* A body that is no smaller than the datagram is replaced by the datagram itself */
+    BodySize =
+        TO_LAB_CompressBlock(Comp, Start, Start + DataSize, &Comp->Output[TO_LAB_COMPRESS_HDR_SIZE], DataSize - 1);
+    if (BodySize == 0)
+    {
+        memcpy(&Comp->Output[TO_LAB_COMPRESS_HDR_SIZE], DataPtr, DataSize);
+        BodySize = DataSize;
+        Flags |= TO_LAB_COMPRESS_FLAG_STORED;
+    }
+
+    Comp->Output[0] = TO_LAB_COMPRESS_MAGIC_0;
+    Comp->Output[1] = TO_LAB_COMPRESS_MAGIC_1;
+    Comp->Output[2] = TO_LAB_COMPRESS_VERSION;
+    Comp->Output[3] = Flags;
+    Comp->Output[4] = (uint8)(Comp->Sequence >> 8);
+    Comp->Output[5] = (uint8)Comp->Sequence;
+    Comp->Output[6] = (uint8)(DataSize >> 8);
+    Comp->Output[7] = (uint8)DataSize;
+
+    Comp->HistorySize = Start + DataSize;
+    ++Comp->Sequence;
+    ++Comp->SinceReset;
+
+    return TO_LAB_COMPRESS_HDR_SIZE + BodySize;
+}
@@ -0,0 +1,153 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Datagram compression for the TO lab output path
+ *
+ * A channel with compression enabled sends every datagram of up to
+ * TO_LAB_COMPRESS_MAX_INPUT bytes, batched or not, in the following form
+ * (all multi-byte fields big endian):
+ *
+ *     Offset  Size  Field
+ *     0       1     Magic, 0x54 ('T')
+ *     1       1     Magic, 0x5A ('Z')
+ *     2       1     Compression format version, currently 1
+ *     3       1     Flags: 0x01 history reset, 0x02 stored
+ *     4       2     Sequence number, one more than the previous one sent
+ *     6       2     Length N of the original datagram in bytes
+ *     8       ...   Body
+ *
+ * The original datagram is what would have been sent without compression,
+ * so it is itself either a batch or a plain packet.  Larger datagrams are
+ * sent as they are; like batches, they are told apart by the first byte.
+ *
+ * The body of a stored datagram is the original datagram.  Otherwise it is
+ * a series of sequences, each made of:
+ *
+ *     - A token byte; the high nibble is the literal count L, the low
+ *       nibble the match length M minus 4
+ *     - If L is 15, extension bytes added to it, up to and including the
+ *       first one below 255
+ *     - L literal bytes
+ *     - If any body remains: a 2 byte match offset D, then, if M - 4 is 15,
+ *       extension bytes as for L
+ *
+ * A match repeats the M bytes starting D bytes back in the history, one
+ * byte at a time, so it may overlap its own output.  The history is the
+ * original datagrams since the last one flagged as a history reset,
+ * trimmed as described for TO_LAB_CompressHistory_t, followed by the
+ * output produced so far.
+ *
+ * History makes the repetition between successive housekeeping packets
+ * compressible, but means a lost datagram leaves the ground unable to
+ * expand anything until the next reset.  A channel resets its history
+ * every ResetInterval datagrams, when output is enabled, and after any
+ * datagram fails to go out.  The ground detects loss by a gap in the
+ * sequence numbers.
+ *
+ * Nothing here depends on the rest of the application.  The reference
+ * decoder, TO_LAB_CompressDecode(), is in to_lab_decompress.c, which ground
+ * tools and the unit tests build but the application does not.
+ */
+
+#ifndef TO_LAB_COMPRESS_H
+#define TO_LAB_COMPRESS_H
+
+#include "common_types.h"
+
+#include "to_lab_platform_cfg.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define TO_LAB_COMPRESS_MAGIC_0   0x54
+#define TO_LAB_COMPRESS_MAGIC_1   0x5A
+#define TO_LAB_COMPRESS_VERSION   1
+#define TO_LAB_COMPRESS_HDR_SIZE  8
+#define TO_LAB_COMPRESS_MIN_MATCH 4
+
+#define TO_LAB_COMPRESS_FLAG_RESET  0x01
+#define TO_LAB_COMPRESS_FLAG_STORED 0x02
+
+#define TO_LAB_COMPRESS_HASH_SIZE (1 << TO_LAB_COMPRESS_HASH_BITS)
+
+/* A channel's compressor only has working storage with TO_LAB_COMPRESS_ENABLE */
+#define TO_LAB_COMPRESS_IF_ENABLED(Value) (TO_LAB_COMPRESS_ENABLE ? (Value) : 1)
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * Recent original datagrams, shared in form by the compressor and decoder
+ *
+ * A datagram is placed right after the history, then becomes part of it.
+ * Once another datagram might not fit, all but the last
+ * TO_LAB_COMPRESS_WINDOW bytes are dropped, so both sides trim at the same
+ * points.
+ */
+typedef struct
+{
+    uint16 Size; /**< Bytes of history at the start of Data */
+    uint8  Data[2 * TO_LAB_COMPRESS_WINDOW];
+} TO_LAB_CompressHistory_t;
+
+/**
+ * Compression state of one channel
+ *
+ * The history has the same form as TO_LAB_CompressHistory_t.
+ */
+typedef struct
+{
+    bool   Enabled;
+    bool   ResetPending;  /**< Reset the history before the next datagram */
+    uint16 ResetInterval; /**< Datagrams between history resets, 0 for none */
+    uint16 SinceReset;    /**< Datagrams sent since the last reset */
+    uint16 Sequence;      /**< Sequence number of the next datagram */
+
+    /** Last position + 1 of each 4 byte hash, 0 if none */
+    uint16 Hash[TO_LAB_COMPRESS_IF_ENABLED(TO_LAB_COMPRESS_HASH_SIZE)];
+    uint16 HistorySize; /**< Bytes of history at the start of HistoryData */
+    uint8  HistoryData[TO_LAB_COMPRESS_IF_ENABLED(2 * TO_LAB_COMPRESS_WINDOW)];
+    uint8  Output[TO_LAB_COMPRESS_IF_ENABLED(TO_LAB_COMPRESS_HDR_SIZE + TO_LAB_COMPRESS_MAX_INPUT)];
+} TO_LAB_Compress_t;
+
+/**
+ * Ground side decoder state for one channel
+ */
+typedef struct
+{
+    bool                     Synced;       /**< History matches the sender's */
+    uint16                   NextSequence; /**< Sequence number expected next */
+    TO_LAB_CompressHistory_t History;
+} TO_LAB_Decompress_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+void   TO_LAB_CompressInit(TO_LAB_Compress_t *Comp, bool Enabled, uint16 ResetInterval);
+size_t TO_LAB_CompressDatagram(TO_LAB_Compress_t *Comp, const void *DataPtr, size_t DataSize);
+uint16 TO_LAB_CompressTrimHistory(uint8 *Data, size_t Capacity, uint16 *Size);
+bool   TO_LAB_CompressDecode(TO_LAB_Decompress_t *Decomp, const void *DatagramPtr, size_t DatagramSize,
+                             const uint8 **DataOut, size_t *SizeOut);
+
+#endif
@@ -0,0 +1,189 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the reference decoder for datagrams compressed by the
+ *  TO lab application.  It is for ground tools and unit tests, and is not
+ *  built into the application.
+ */
+
+#include <string.h>
+
+#include "to_lab_compress.h"
+
+/*
+ * --------------------------------------------
+ * Read a nibble overflow length, as written by TO_LAB_CompressPutLength()
+ * --------------------------------------------
+ */
+static bool TO_LAB_CompressGetLength(const uint8 *In, size_t *InPos, size_t InSize, size_t *Length)
+{
+    uint8 Byte;
+
+    do
+    {
+        if (*InPos >= InSize)
+        {
+            return false;
+        }
+        Byte = In[(*InPos)++];
+        *Length += Byte;
+    } while (Byte == 255);
+
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_CompressDecode() -- Reference decoder for ground tools   */
+/*                                                                 */
+/* Expands one received datagram in the compressed form.  Returns  */
+/* false if it is malformed or cannot be expanded because an       */
+/* earlier one was lost; decoding resumes at the next reset.  On   */
+/* success *DataOut points into Decomp and stays valid until the   */
+/* next call.                                                      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_CompressDecode(TO_LAB_Decompress_t *Decomp, const void *DatagramPtr, size_t DatagramSize,
+                           const uint8 **DataOut, size_t *SizeOut)
+{
+    TO_LAB_CompressHistory_t *History = &Decomp->History;
+    const uint8              *In      = DatagramPtr;
+    size_t                    InPos   = TO_LAB_COMPRESS_HDR_SIZE;
+    uint8                     Flags;
+    uint16                    Sequence;
+    size_t                    RawSize;
+    size_t                    Start;
+    size_t                    OutPos;
+    size_t                    LitLen;
+    size_t                    MatchLen;
+    size_t                    MatchOffset;
+    uint8                     Token;
+
+    if (DatagramSize < TO_LAB_COMPRESS_HDR_SIZE || In[0] != TO_LAB_COMPRESS_MAGIC_0 ||
+        In[1] != TO_LAB_COMPRESS_MAGIC_1 || In[2] != TO_LAB_COMPRESS_VERSION)
+    {
+        return false;
+    }
+
+    Flags    = In[3];
+    Sequence = (uint16)((In[4] << 8) | In[5]);
+    RawSize  = ((size_t)In[6] << 8) | In[7];
+
+    if (Flags & TO_LAB_COMPRESS_FLAG_RESET)
+    {
+        History->Size  = 0;
+        Decomp->Synced = true;
+    }
+    else if (!Decomp->Synced || Sequence != Decomp->NextSequence)
+    {
+        Decomp->Synced = false;
+        return false;
+    }
+
+    Decomp->NextSequence = Sequence + 1;
+
+    /* Anything malformed from here on leaves the history unusable */
+    Decomp->Synced = false;
+
+    if (RawSize == 0 || RawSize > TO_LAB_COMPRESS_MAX_INPUT)
+    {
+        return false;
+    }
+
+    TO_LAB_CompressTrimHistory(History->Data, sizeof(History->Data), &History->Size);
+    Start  = History->Size;
+    OutPos = Start;
+
+    if (Flags & TO_LAB_COMPRESS_FLAG_STORED)
+    {
+        if ((DatagramSize - InPos) != RawSize)
+        {
+            return false;
+        }
+
+        memcpy(&History->Data[Start], &In[InPos], RawSize);
+        OutPos = Start + RawSize;
+    }
+    else
+    {
+        while (InPos < DatagramSize)
+        {
+            Token  = In[InPos++];
+            LitLen = Token >> 4;
+            if (LitLen == 15 && !TO_LAB_CompressGetLength(In, &InPos, DatagramSize, &LitLen))
+            {
+                return false;
+            }
+
+            if (LitLen > (DatagramSize - InPos) || LitLen > (Start + RawSize - OutPos))
+            {
+                return false;
+            }
+
+            memcpy(&History->Data[OutPos], &In[InPos], LitLen);
+            InPos += LitLen;
+            OutPos += LitLen;
+
+            if (InPos >= DatagramSize)
+            {
+                break;
+            }
+
+            if ((DatagramSize - InPos) < 2)
+            {
+                return false;
+            }
+            MatchOffset = ((size_t)In[InPos] << 8) | In[InPos + 1];
+            InPos += 2;
+
+            MatchLen = Token & 0x0F;
+            if (MatchLen == 15 && !TO_LAB_CompressGetLength(In, &InPos, DatagramSize, &MatchLen))
+            {
+                return false;
+            }
+            MatchLen += TO_LAB_COMPRESS_MIN_MATCH;
+
+            if (MatchOffset == 0 || MatchOffset > OutPos || MatchLen > (Start + RawSize - OutPos))
+            {
+                return false;
+            }
+
+            while (MatchLen != 0)
+            {
+                History->Data[OutPos] = History->Data[OutPos - MatchOffset];
+                ++OutPos;
+                --MatchLen;
+            }
+        }
+    }
+
+    if (OutPos != (Start + RawSize))
+    {
+        return false;
+    }
+
+    History->Size  = OutPos;
+    Decomp->Synced = true;
+
+    *DataOut = &History->Data[Start];
+    *SizeOut = RawSize;
+
+    return true;
+}
@@ -0,0 +1,265 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the delta encoding of repeated packets for the TO lab
+ *  application
+ */
+
+#include <string.h>
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_delta.h"
+
+CompileTimeAssert(TO_LAB_DELTA_CACHE_ENTRIES > 0, TO_LAB_DeltaCacheTooSmall);
+CompileTimeAssert(TO_LAB_DELTA_MAX_PACKET <= 0xFFFF, TO_LAB_DeltaPacketTooLarge);
+
+/*
+ * --------------------------------------------
+ * Find the entry of a stream on a channel, taking a free or the least
+ * recently used entry if it has none
+ * --------------------------------------------
+ */
+static TO_LAB_DeltaEntry_t *TO_LAB_DeltaGetEntry(TO_LAB_Stream_t *Stream, uint16 ChannelIdx)
+{
+    TO_LAB_DeltaCache_t *Cache = &TO_LAB_Global.Delta;
+    TO_LAB_DeltaEntry_t *Entry;
+    uint16               EntryIdx;
+    uint16               i;
+
+    EntryIdx = Stream->DeltaEntry[ChannelIdx];
+    if (EntryIdx != 0)
+    {
+        return &Cache->Entry[EntryIdx - 1];
+    }
+
+    EntryIdx = 0;
+    for (i = 0; i < TO_LAB_DELTA_CACHE_ENTRIES; i++)
+    {
+        if (Cache->Entry[i].Stream == NULL)
+        {
+            EntryIdx = i;
+            break;
+        }
+
+        if (Cache->Entry[i].LastUse < Cache->Entry[EntryIdx].LastUse)
+        {
+            EntryIdx = i;
+        }
+    }
+
+    Entry = &Cache->Entry[EntryIdx];
+    if (Entry->Stream != NULL)
+    {
+        Entry->Stream->DeltaEntry[Entry->ChannelIdx] = 0;
+        ++TO_LAB_Global.HkTlm.Payload.DeltaEvictCount;
+    }
+
+    /* The sequence carries on, so the ground sees a keyframe, not a gap */
+    Entry->Stream     = Stream;
+    Entry->ChannelIdx = ChannelIdx;
+    Entry->Size       = 0;
+    Entry->Sequence   = Stream->DeltaSequence[ChannelIdx];
+
+    Stream->DeltaEntry[ChannelIdx] = EntryIdx + 1;
+
+    return Entry;
+}
+
+/*
+ * --------------------------------------------
+ * Run length code New XOR Ref into Out.  Returns the body size, or 0 if
+ * it would not be smaller than OutLimit bytes.
+ * --------------------------------------------
+ */
+static size_t TO_LAB_DeltaXorRle(const uint8 *Ref, const uint8 *New, size_t Size, uint8 *Out, size_t OutLimit)
+{
+    size_t Pos    = 0;
+    size_t OutPos = 0;
+    size_t RunEnd;
+    size_t i;
+
+    /* Unchanged bytes at the end need no coding */
+    while (Size > 0 && Ref[Size - 1] == New[Size - 1])
+    {
+        --Size;
+    }
+
+    while (Pos < Size)
+    {
+        RunEnd = Pos;
+        while (RunEnd < Size && (RunEnd - Pos) < 128 && Ref[RunEnd] == New[RunEnd])
+        {
+            ++RunEnd;
+        }
+
+        if (RunEnd != Pos)
+        {
+            if (OutPos >= OutLimit)
+            {
+                return 0;
+            }
+            Out[OutPos++] = (uint8)(RunEnd - Pos - 1);
+            Pos           = RunEnd;
+            continue;
+        }
+
+        while (RunEnd < Size && (RunEnd - Pos) < 128 && Ref[RunEnd] != New[RunEnd])
+        {
+            ++RunEnd;
+        }
+
+        if ((OutPos + 1 + (RunEnd - Pos)) > OutLimit)
+        {
+            return 0;
+        }
+
+        Out[OutPos++] = (uint8)(0x7F + (RunEnd - Pos));
+        for (i = Pos; i < RunEnd; ++i)
+        {
+            Out[OutPos++] = Ref[i] ^ New[i];
+        }
+        Pos = RunEnd;
+    }
+
+    /* A packet identical to its reference still needs one byte of body */
+    if (OutPos == 0)
+    {
+        if (OutLimit == 0)
+        {
+            return 0;
+        }
+        Out[OutPos++] = 0;
+    }
+
+    return OutPos;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_DeltaEncode() -- Delta encode one outgoing packet        */
+/*                                                                 */
+/* Returns the size of the result in TO_LAB_Global.Delta.Output,   */
+/* or 0 if the packet is too large and must be sent plain.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+size_t TO_LAB_DeltaEncode(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, const void *NetBufPtr, size_t NetBufSize)
+{
+    TO_LAB_DeltaCache_t *Cache  = &TO_LAB_Global.Delta;
+    uint8               *Output = Cache->Output;
+    TO_LAB_DeltaEntry_t *Entry;
+    uint8               *Ref;
+    uint32               MsgIdValue;
+    size_t               BodySize = 0;
+    uint8                Flags    = 0;
+
+    if (NetBufSize == 0 || NetBufSize > TO_LAB_DELTA_MAX_PACKET)
+    {
+        return 0;
+    }
+
+    Entry          = TO_LAB_DeltaGetEntry(Stream, ChannelIdx);
+    Entry->LastUse = ++Cache->UseClock;
+    Ref            = Cache->Data[Entry - Cache->Entry];
+
+    if (Entry->Size == NetBufSize && Entry->SinceKey < (TO_LAB_DELTA_KEYFRAME_INTERVAL - 1))
+    {
+        BodySize = TO_LAB_DeltaXorRle(Ref, NetBufPtr, NetBufSize, &Output[TO_LAB_DELTA_HDR_SIZE], NetBufSize - 1);
+    }
+
+    if (BodySize == 0)
+    {
+        memcpy(&Output[TO_LAB_DELTA_HDR_SIZE], NetBufPtr, NetBufSize);
+        BodySize        = NetBufSize;
+        Flags           = TO_LAB_DELTA_FLAG_KEYFRAME;
+        Entry->SinceKey = 0;
+        ++TO_LAB_Global.HkTlm.Payload.DeltaKeyframeCount;
+    }
+    else
+    {
+        ++Entry->SinceKey;
+    }
+
+    MsgIdValue = CFE_SB_MsgIdToValue(Stream->MsgId);
+
+    Output[0]  = TO_LAB_DELTA_MAGIC_0;
+    Output[1]  = TO_LAB_DELTA_MAGIC_1;
+    Output[2]  = TO_LAB_DELTA_VERSION;
+    Output[3]  = Flags;
+    Output[4]  = (uint8)(MsgIdValue >> 24);
+    Output[5]  = (uint8)(MsgIdValue >> 16);
+    Output[6]  = (uint8)(MsgIdValue >> 8);
+    Output[7]  = (uint8)MsgIdValue;
+    Output[8]  = (uint8)(Entry->Sequence >> 8);
+    Output[9]  = (uint8)Entry->Sequence;
+    Output[10] = (uint8)(NetBufSize >> 8);
+    Output[11] = (uint8)NetBufSize;
+
+    memcpy(Ref, NetBufPtr, NetBufSize);
+    Entry->Size = NetBufSize;
+    ++Entry->Sequence;
+    Stream->DeltaSequence[ChannelIdx] = Entry->Sequence;
+
+    TO_LAB_Global.HkTlm.Payload.DeltaInBytes += NetBufSize;
+    TO_LAB_Global.HkTlm.Payload.DeltaOutBytes += TO_LAB_DELTA_HDR_SIZE + BodySize;
+
+    return TO_LAB_DELTA_HDR_SIZE + BodySize;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_DeltaResetStream() -- Start a stream over with a         */
+/*                              keyframe                           */
+/*                                                                 */
+/* Used when the last packet encoded never left, so the ground has */
+/* no copy of the reference the next delta would refer to.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_DeltaResetStream(TO_LAB_Stream_t *Stream, uint16 ChannelIdx)
+{
+    uint16 EntryIdx;
+
+    EntryIdx = Stream->DeltaEntry[ChannelIdx];
+    if (EntryIdx != 0)
+    {
+        TO_LAB_Global.Delta.Entry[EntryIdx - 1].Size = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_DeltaResetChannel() -- Start every stream of a channel   */
+/*                               over with a keyframe              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_DeltaResetChannel(uint16 ChannelIdx)
+{
+    TO_LAB_DeltaCache_t *Cache = &TO_LAB_Global.Delta;
+    uint16               i;
+
+    for (i = 0; i < TO_LAB_DELTA_CACHE_ENTRIES; i++)
+    {
+        if (Cache->Entry[i].Stream != NULL && Cache->Entry[i].ChannelIdx == ChannelIdx)
+        {
+            Cache->Entry[i].Size = 0;
+        }
+    }
+}
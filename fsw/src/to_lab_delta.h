@@ -0,0 +1,116 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Delta encoding of repeated packets for the TO lab output path
+ *
+ * A stream subscribed with TO_LAB_SUB_OPT_DELTA is sent, on that channel,
+ * in the following form rather than as plain packets (all multi-byte
+ * fields big endian):
+ *
+ *     Offset  Size  Field
+ *     0       1     Magic, 0x54 ('T')
+ *     1       1     Magic, 0x44 ('D')
+ *     2       1     Delta format version, currently 1
+ *     3       1     Flags: 0x01 keyframe
+ *     4       4     MsgId value of the stream
+ *     8       2     Sequence number, one more than the stream's previous one
+ *     10      2     Length N of the packet in bytes
+ *     12      ...   Body
+ *
+ * The body of a keyframe is the packet itself.  Otherwise it is the packet
+ * XORed with the previous packet of the stream, run length coded as a
+ * series of control bytes: 0x00-0x7F skip that many plus one unchanged
+ * bytes, 0x80-0xFF are followed by that many minus 0x7F XOR bytes.  Bytes
+ * past the end of the body are unchanged.  Like batches, these are told
+ * apart from plain packets by the first byte, and may themselves be
+ * batched or compressed.
+ *
+ * A keyframe is sent every TO_LAB_DELTA_KEYFRAME_INTERVAL packets, when
+ * the packet size changes, when output is enabled, after a packet of the
+ * stream was lost on output, and whenever the stream has no reference
+ * copy in the cache.  A ground station that sees
+ * a gap in the sequence numbers waits for the next keyframe.
+ *
+ * Reference copies are kept in a fixed cache of TO_LAB_DELTA_CACHE_BYTES,
+ * split into entries of TO_LAB_DELTA_MAX_PACKET bytes.  When more streams
+ * use delta encoding than there are entries, the least recently used
+ * entry is taken over.  Larger packets are always sent plain.
+ */
+
+#ifndef TO_LAB_DELTA_H
+#define TO_LAB_DELTA_H
+
+#include "common_types.h"
+#include "cfe_sb.h"
+
+#include "to_lab_platform_cfg.h"
+#include "to_lab_streams.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define TO_LAB_DELTA_MAGIC_0  0x54
+#define TO_LAB_DELTA_MAGIC_1  0x44
+#define TO_LAB_DELTA_VERSION  1
+#define TO_LAB_DELTA_HDR_SIZE 12
+
+#define TO_LAB_DELTA_FLAG_KEYFRAME 0x01
+
+#define TO_LAB_DELTA_CACHE_ENTRIES (TO_LAB_DELTA_CACHE_BYTES / TO_LAB_DELTA_MAX_PACKET)
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * Reference copy of the last packet of one stream sent on one channel
+ */
+typedef struct
+{
+    TO_LAB_Stream_t *Stream;     /**< Owner, NULL if the entry is free */
+    uint16           ChannelIdx; /**< Channel of the owner */
+    uint16           Size;       /**< Size of the reference copy, 0 if there is none */
+    uint16           Sequence;   /**< Sequence number of the next packet */
+    uint16           SinceKey;   /**< Packets sent since the last keyframe */
+    uint32           LastUse;    /**< Value of UseClock when last used */
+} TO_LAB_DeltaEntry_t;
+
+/**
+ * The reference copy cache
+ */
+typedef struct
+{
+    uint32              UseClock; /**< Counts cache uses, orders entries for eviction */
+    TO_LAB_DeltaEntry_t Entry[TO_LAB_DELTA_CACHE_ENTRIES];
+    uint8               Data[TO_LAB_DELTA_CACHE_ENTRIES][TO_LAB_DELTA_MAX_PACKET];
+    uint8               Output[TO_LAB_DELTA_HDR_SIZE + TO_LAB_DELTA_MAX_PACKET];
+} TO_LAB_DeltaCache_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+size_t TO_LAB_DeltaEncode(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, const void *NetBufPtr, size_t NetBufSize);
+void   TO_LAB_DeltaResetStream(TO_LAB_Stream_t *Stream, uint16 ChannelIdx);
+void   TO_LAB_DeltaResetChannel(uint16 ChannelIdx);
+
+#endif
@@ -71,6 +71,30 @@ void TO_LAB_ProcessGroundCommand(const CFE_SB_Buffer_t *SBBufPtr)
             TO_LAB_EnableOutputCmd((const TO_LAB_EnableOutputCmd_t *)SBBufPtr);
             break;
 
+        case TO_LAB_CHANNEL_OUTPUT_ENABLE_CC:
+            TO_LAB_EnableChannelOutputCmd((const TO_LAB_EnableChannelOutputCmd_t *)SBBufPtr);
+            break;
+
+        case TO_LAB_CHANNEL_OUTPUT_DISABLE_CC:
+            TO_LAB_DisableChannelOutputCmd((const TO_LAB_DisableChannelOutputCmd_t *)SBBufPtr);
+            break;
+
+        case TO_LAB_CHANNEL_ADD_PKT_CC:
+            TO_LAB_AddChannelPacketCmd((const TO_LAB_AddChannelPacketCmd_t *)SBBufPtr);
+            break;
+
+        case TO_LAB_CHANNEL_REMOVE_PKT_CC:
+            TO_LAB_RemoveChannelPacketCmd((const TO_LAB_RemoveChannelPacketCmd_t *)SBBufPtr);
+            break;
+
+        case TO_LAB_SET_RATE_LIMIT_CC:
+            TO_LAB_SetRateLimitCmd((const TO_LAB_SetRateLimitCmd_t *)SBBufPtr);
+            break;
+
+        case TO_LAB_SET_COMPRESSION_CC:
+            TO_LAB_SetCompressionCmd((const TO_LAB_SetCompressionCmd_t *)SBBufPtr);
+            break;
+
         default:
             CFE_EVS_SendEvent(TO_LAB_FNCODE_ERR_EID, CFE_EVS_EventType_ERROR,
                               "L%d TO: Invalid Function Code Rcvd In Ground Command 0x%x", __LINE__,
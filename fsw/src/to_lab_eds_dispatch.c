@@ -36,13 +36,19 @@
 #include "to_lab_eds_dispatcher.h"
 
 static const EdsDispatchTable_TO_LAB_Application_CFE_SB_Telecommand_t TO_LAB_TC_DISPATCH_TABLE = {
-    .CMD     = {.AddPacketCmd_indication     = TO_LAB_AddPacketCmd,
-            .NoopCmd_indication          = TO_LAB_NoopCmd,
-            .EnableOutputCmd_indication  = TO_LAB_EnableOutputCmd,
-            .RemoveAllCmd_indication     = TO_LAB_RemoveAllCmd,
-            .RemovePacketCmd_indication  = TO_LAB_RemovePacketCmd,
-            .ResetCountersCmd_indication = TO_LAB_ResetCountersCmd,
-            .SendDataTypesCmd_indication = TO_LAB_SendDataTypesCmd},
+    .CMD     = {.AddPacketCmd_indication            = TO_LAB_AddPacketCmd,
+            .NoopCmd_indication                 = TO_LAB_NoopCmd,
+            .EnableOutputCmd_indication         = TO_LAB_EnableOutputCmd,
+            .RemoveAllCmd_indication            = TO_LAB_RemoveAllCmd,
+            .RemovePacketCmd_indication         = TO_LAB_RemovePacketCmd,
+            .ResetCountersCmd_indication        = TO_LAB_ResetCountersCmd,
+            .SendDataTypesCmd_indication        = TO_LAB_SendDataTypesCmd,
+            .EnableChannelOutputCmd_indication  = TO_LAB_EnableChannelOutputCmd,
+            .DisableChannelOutputCmd_indication = TO_LAB_DisableChannelOutputCmd,
+            .AddChannelPacketCmd_indication     = TO_LAB_AddChannelPacketCmd,
+            .RemoveChannelPacketCmd_indication  = TO_LAB_RemoveChannelPacketCmd,
+            .SetRateLimitCmd_indication         = TO_LAB_SetRateLimitCmd,
+            .SetCompressionCmd_indication       = TO_LAB_SetCompressionCmd},
     .SEND_HK = {.indication = TO_LAB_SendHkCmd}};
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
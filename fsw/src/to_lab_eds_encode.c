@@ -21,6 +21,8 @@
  *  This file contains the source code for the TO lab application
  */
 
+#include <string.h>
+
 #include "cfe_config.h"
 #include "cfe_sb.h"
 #include "cfe_msg.h"
@@ -28,6 +30,7 @@
 
 #include "to_lab_app.h"
 #include "to_lab_encode.h"
+#include "to_lab_eventids.h"
 
 #include "edslib_datatypedb.h"
 #include "cfe_missionlib_api.h"
@@ -37,19 +40,413 @@
 
 #include "cfe_hdr_eds_datatypes.h"
 
-CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, const void **DestBufferOut,
-                                        size_t *DestSizeOut)
+/* Encode buffers are sized to SB messages, so any packed telemetry must fit one */
+CompileTimeAssert(sizeof(EdsPackedBuffer_CFE_HDR_TelemetryHeader_t) <= CFE_MISSION_SB_MAX_SB_MSG_SIZE,
+                  TO_LAB_PackedTelemetryTooLarge);
+
+/*
+ * Plan state of a cached type
+ */
+typedef enum
+{
+    TO_LAB_PackPlanState_NONE,        /**< No plan attempted yet */
+    TO_LAB_PackPlanState_READY,       /**< Plan built and verified, use it */
+    TO_LAB_PackPlanState_UNAVAILABLE, /**< Type cannot be planned, use the generic packer */
+} TO_LAB_PackPlanState_t;
+
+/*
+ * One step of a flat pack plan: copy Size bytes from the native object at
+ * SrcOffset to the packed buffer at DstOffset, reversing byte order if Swap.
+ */
+typedef struct
+{
+    uint32 SrcOffset;
+    uint32 DstOffset;
+    uint16 Size;
+    bool   Swap;
+} TO_LAB_PackOp_t;
+
+/*
+ * Resolved EDS type information for one telemetry TopicId.
+ *
+ * Resolving a TopicId to its EDS type is the same for every packet of that
+ * topic, so the result is kept in a small direct-mapped cache and only the
+ * pack step is done per packet.
+ */
+typedef struct
+{
+    bool                         IsValid;
+    uint16                       TopicId;
+    EdsLib_Id_t                  EdsId;
+    EdsLib_DataTypeDB_TypeInfo_t TypeInfo;
+    TO_LAB_PackPlanState_t       PlanState;
+    uint16                       PlanFirstOp; /**< Index of the first op in TO_LAB_PackOpPool */
+    uint16                       PlanNumOps;
+} TO_LAB_EdsTypeCacheEntry_t;
+
+static TO_LAB_EdsTypeCacheEntry_t TO_LAB_EdsTypeCache[TO_LAB_ENCODE_CACHE_SIZE];
+
+/*
+ * Storage for the ops of every plan, handed out in order as plans are built.
+ * Once it runs out, further types use the generic packer.
+ */
+static TO_LAB_PackOp_t TO_LAB_PackOpPool[TO_LAB_PACK_PLAN_POOL_OPS];
+static uint16          TO_LAB_PackOpPoolUsed;
+
+/*
+ * Serializes the type cache, plan building and verification when encode
+ * workers run in parallel.  A plan, once built, is only read until the
+ * cache is invalidated, which happens only while no encode is in progress.
+ */
+static osal_id_t TO_LAB_EncodeMutex;
+
+/*
+ * --------------------------------------------
+ * Set up the encoder's shared state
+ * --------------------------------------------
+ */
+CFE_Status_t TO_LAB_EncodeInit(void)
+{
+    if (TO_LAB_ENCODE_WORKERS > 0 && OS_MutSemCreate(&TO_LAB_EncodeMutex, "TO_LAB_ENC_MUT", 0) != OS_SUCCESS)
+    {
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+static inline void TO_LAB_EncodeLock(void)
+{
+    if (TO_LAB_ENCODE_WORKERS > 0)
+    {
+        OS_MutSemTake(TO_LAB_EncodeMutex);
+    }
+}
+
+static inline void TO_LAB_EncodeUnlock(void)
+{
+    if (TO_LAB_ENCODE_WORKERS > 0)
+    {
+        OS_MutSemGive(TO_LAB_EncodeMutex);
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Forget all resolved types and their plans.  Called whenever the set of
+ * subscribed streams changes.
+ * --------------------------------------------
+ */
+void TO_LAB_EncodeInvalidateCache(void)
+{
+    memset(TO_LAB_EdsTypeCache, 0, sizeof(TO_LAB_EdsTypeCache));
+    TO_LAB_PackOpPoolUsed = 0;
+}
+
+/*
+ * --------------------------------------------
+ * Append a copy op to the plan under construction, merging it with the
+ * previous op when both are plain copies of adjacent bytes.
+ * --------------------------------------------
+ */
+static bool TO_LAB_PackPlanAddOp(TO_LAB_EdsTypeCacheEntry_t *Entry, uint32 SrcOffset, uint32 DstBitOffset,
+                                 const EdsLib_SizeInfo_t *Size, bool Swap)
+{
+    TO_LAB_PackOp_t *Op;
+
+    /* Only whole bytes that pack at their native width can be planned */
+    if ((DstBitOffset % 8) != 0 || Size->Bits != (8 * Size->Bytes) || Size->Bytes == 0)
+    {
+        return false;
+    }
+
+    if (Entry->PlanNumOps != 0 && !Swap)
+    {
+        Op = &TO_LAB_PackOpPool[Entry->PlanFirstOp + Entry->PlanNumOps - 1];
+        if (!Op->Swap && (Op->SrcOffset + Op->Size) == SrcOffset && (Op->DstOffset + Op->Size) == (DstBitOffset / 8) &&
+            (Op->Size + Size->Bytes) <= 0xFFFF)
+        {
+            Op->Size += Size->Bytes;
+            return true;
+        }
+    }
+
+    if ((Entry->PlanFirstOp + Entry->PlanNumOps) >= TO_LAB_PACK_PLAN_POOL_OPS)
+    {
+        return false;
+    }
+
+    Op            = &TO_LAB_PackOpPool[Entry->PlanFirstOp + Entry->PlanNumOps];
+    Op->SrcOffset = SrcOffset;
+    Op->DstOffset = DstBitOffset / 8;
+    Op->Size      = Size->Bytes;
+    Op->Swap      = Swap;
+
+    ++Entry->PlanNumOps;
+    return true;
+}
+
+/*
+ * --------------------------------------------
+ * Flatten an EDS type into copy ops, recursing through containers and arrays
+ * --------------------------------------------
+ */
+static bool TO_LAB_PackPlanAddType(const EdsLib_DatabaseObject_t *EDS_DB, TO_LAB_EdsTypeCacheEntry_t *Entry,
+                                   EdsLib_Id_t EdsId, uint32 SrcOffset, uint32 DstBitOffset, uint32 Depth)
+{
+    static const union
+    {
+        uint16 Word;
+        uint8  Byte[2];
+    } HostOrder = {.Word = 1};
+
+    EdsLib_DataTypeDB_TypeInfo_t   TypeInfo;
+    EdsLib_DataTypeDB_EntityInfo_t MemberInfo;
+    uint16                         i;
+
+    if (Depth > TO_LAB_PACK_PLAN_MAX_DEPTH || EdsLib_DataTypeDB_GetTypeInfo(EDS_DB, EdsId, &TypeInfo) != EDSLIB_SUCCESS)
+    {
+        return false;
+    }
+
+    switch (TypeInfo.ElemType)
+    {
+        case EDSLIB_BASICTYPE_CONTAINER:
+        case EDSLIB_BASICTYPE_ARRAY:
+            for (i = 0; i < TypeInfo.NumSubElements; ++i)
+            {
+                if (EdsLib_DataTypeDB_GetMemberByIndex(EDS_DB, EdsId, i, &MemberInfo) != EDSLIB_SUCCESS ||
+                    !TO_LAB_PackPlanAddType(EDS_DB, Entry, MemberInfo.EdsId, SrcOffset + MemberInfo.Offset.Bytes,
+                                            DstBitOffset + MemberInfo.Offset.Bits, Depth + 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+
+        case EDSLIB_BASICTYPE_SIGNED_INT:
+        case EDSLIB_BASICTYPE_UNSIGNED_INT:
+        case EDSLIB_BASICTYPE_FLOAT:
+            /* Packed numbers are big endian; a wrong guess is caught by TO_LAB_PackPlanSelfTest() */
+            return TO_LAB_PackPlanAddOp(Entry, SrcOffset, DstBitOffset, &TypeInfo.Size,
+                                        (HostOrder.Byte[0] == 1 && TypeInfo.Size.Bytes > 1));
+
+        case EDSLIB_BASICTYPE_BINARY:
+            return TO_LAB_PackPlanAddOp(Entry, SrcOffset, DstBitOffset, &TypeInfo.Size, false);
+
+        default:
+            return false;
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Run a plan: produce the packed form of SourceBuffer in DestBuffer
+ * --------------------------------------------
+ */
+static void TO_LAB_PackPlanExecute(const TO_LAB_EdsTypeCacheEntry_t *Entry, const void *SourceBuffer,
+                                   uint8 *DestBuffer)
+{
+    const TO_LAB_PackOp_t *Op;
+    const uint8           *Src;
+    uint8                 *Dst;
+    uint16                 i;
+    uint16                 j;
+
+    /* Bits not covered by any op (padding, spares) pack as zero */
+    memset(DestBuffer, 0, (Entry->TypeInfo.Size.Bits + 7) / 8);
+
+    Op = &TO_LAB_PackOpPool[Entry->PlanFirstOp];
+    for (i = 0; i < Entry->PlanNumOps; ++i)
+    {
+        Src = (const uint8 *)SourceBuffer + Op->SrcOffset;
+        Dst = DestBuffer + Op->DstOffset;
+
+        if (Op->Swap)
+        {
+            for (j = 0; j < Op->Size; ++j)
+            {
+                Dst[j] = Src[Op->Size - 1 - j];
+            }
+        }
+        else
+        {
+            memcpy(Dst, Src, Op->Size);
+        }
+
+        ++Op;
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Pack with the generic EdsLib packer
+ * --------------------------------------------
+ */
+static int32 TO_LAB_PackGeneric(const EdsLib_DatabaseObject_t *EDS_DB, const TO_LAB_EdsTypeCacheEntry_t *Entry,
+                                const CFE_SB_Buffer_t *SourceBuffer, size_t SourceBufferSize, void *DestBuffer,
+                                size_t DestBufferSize)
+{
+    /* Pack may update the ID it is given, so work on a copy of the cached one */
+    EdsLib_Id_t EdsId = Entry->EdsId;
+
+    if (((Entry->TypeInfo.Size.Bits + 7) / 8) <= DestBufferSize)
+    {
+        memset(DestBuffer, 0, (Entry->TypeInfo.Size.Bits + 7) / 8);
+    }
+
+    return EdsLib_DataTypeDB_PackCompleteObject(EDS_DB, &EdsId, DestBuffer, SourceBuffer, 8 * DestBufferSize,
+                                                SourceBufferSize);
+}
+
+/*
+ * --------------------------------------------
+ * Check a plan's output for one packet against the generic packer.
+ * A plan that ever disagrees is discarded for good.
+ * --------------------------------------------
+ */
+static void TO_LAB_PackPlanVerify(const EdsLib_DatabaseObject_t *EDS_DB, TO_LAB_EdsTypeCacheEntry_t *Entry,
+                                  const CFE_SB_Buffer_t *SourceBuffer, size_t SourceBufferSize,
+                                  const void *PlanOutput)
+{
+    static EdsPackedBuffer_CFE_HDR_TelemetryHeader_t ReferenceBuffer;
+
+    if (TO_LAB_PackGeneric(EDS_DB, Entry, SourceBuffer, SourceBufferSize, ReferenceBuffer, sizeof(ReferenceBuffer)) !=
+            EDSLIB_SUCCESS ||
+        memcmp(ReferenceBuffer, PlanOutput, (Entry->TypeInfo.Size.Bits + 7) / 8) != 0)
+    {
+        CFE_EVS_SendEvent(TO_LAB_PACKPLAN_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Pack plan for topic 0x%x does not match generic packer, disabled",
+                          (unsigned int)Entry->TopicId);
+        Entry->PlanState = TO_LAB_PackPlanState_UNAVAILABLE;
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Check a new plan against the generic packer on a packet whose payload
+ * bytes are all distinct and non-zero, so a field copied from the wrong
+ * place or in the wrong byte order cannot pack the same by chance, as a
+ * zero field would.  The header is taken from the first live packet, so
+ * fields the packer derives from it come out the same.
+ * --------------------------------------------
+ */
+static void TO_LAB_PackPlanSelfTest(const EdsLib_DatabaseObject_t *EDS_DB, TO_LAB_EdsTypeCacheEntry_t *Entry,
+                                    const CFE_SB_Buffer_t *SourceBuffer, size_t SourceBufferSize)
+{
+    static union
+    {
+        CFE_SB_Buffer_t Buffer;
+        uint8           Bytes[CFE_MISSION_SB_MAX_SB_MSG_SIZE];
+    } TestSource;
+    static EdsPackedBuffer_CFE_HDR_TelemetryHeader_t TestOutput;
+    size_t                                           i;
+
+    if (SourceBufferSize > sizeof(TestSource) || SourceBufferSize < sizeof(CFE_MSG_TelemetryHeader_t))
+    {
+        Entry->PlanState = TO_LAB_PackPlanState_UNAVAILABLE;
+        return;
+    }
+
+    memcpy(TestSource.Bytes, SourceBuffer, sizeof(CFE_MSG_TelemetryHeader_t));
+    for (i = sizeof(CFE_MSG_TelemetryHeader_t); i < SourceBufferSize; ++i)
+    {
+        TestSource.Bytes[i] = (uint8)((i % 255) + 1);
+    }
+
+    TO_LAB_PackPlanExecute(Entry, &TestSource.Buffer, (uint8 *)&TestOutput);
+    TO_LAB_PackPlanVerify(EDS_DB, Entry, &TestSource.Buffer, SourceBufferSize, &TestOutput);
+}
+
+/*
+ * --------------------------------------------
+ * Build the flat pack plan for a newly resolved type
+ * --------------------------------------------
+ */
+static void TO_LAB_PackPlanBuild(const EdsLib_DatabaseObject_t *EDS_DB, TO_LAB_EdsTypeCacheEntry_t *Entry,
+                                 const CFE_SB_Buffer_t *SourceBuffer, size_t SourceBufferSize)
+{
+    Entry->PlanFirstOp = TO_LAB_PackOpPoolUsed;
+    Entry->PlanNumOps  = 0;
+
+    if (TO_LAB_PACK_PLAN_ENABLE && Entry->TypeInfo.Size.Bytes <= SourceBufferSize &&
+        Entry->TypeInfo.Size.Bits <= (8 * sizeof(EdsPackedBuffer_CFE_HDR_TelemetryHeader_t)) &&
+        TO_LAB_PackPlanAddType(EDS_DB, Entry, Entry->EdsId, 0, 0, 0))
+    {
+        TO_LAB_PackOpPoolUsed += Entry->PlanNumOps;
+        Entry->PlanState = TO_LAB_PackPlanState_READY;
+
+        TO_LAB_PackPlanSelfTest(EDS_DB, Entry, SourceBuffer, SourceBufferSize);
+    }
+    else
+    {
+        Entry->PlanNumOps = 0;
+        Entry->PlanState  = TO_LAB_PackPlanState_UNAVAILABLE;
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Look up the EDS type for a TopicId, resolving and caching it on a miss
+ * --------------------------------------------
+ */
+static TO_LAB_EdsTypeCacheEntry_t *TO_LAB_EncodeResolveType(const EdsLib_DatabaseObject_t *EDS_DB, uint16 TopicId)
+{
+    TO_LAB_EdsTypeCacheEntry_t *Entry;
+    int32                       EdsStatus;
+
+    Entry = &TO_LAB_EdsTypeCache[TopicId % TO_LAB_ENCODE_CACHE_SIZE];
+
+    if (Entry->IsValid && Entry->TopicId == TopicId)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.EncodeCacheHits;
+        return Entry;
+    }
+
+    ++TO_LAB_Global.HkTlm.Payload.EncodeCacheMisses;
+    memset(Entry, 0, sizeof(*Entry));
+
+    EdsStatus = CFE_MissionLib_GetArgumentType(&CFE_SOFTWAREBUS_INTERFACE, EDS_INTERFACE_ID(CFE_SB_Telemetry), TopicId,
+                                               1, 1, &Entry->EdsId);
+    if (EdsStatus != CFE_MISSIONLIB_SUCCESS)
+    {
+        return NULL;
+    }
+
+    EdsStatus = EdsLib_DataTypeDB_GetTypeInfo(EDS_DB, Entry->EdsId, &Entry->TypeInfo);
+    if (EdsStatus != EDSLIB_SUCCESS)
+    {
+        return NULL;
+    }
+
+    Entry->TopicId = TopicId;
+    Entry->IsValid = true;
+
+    return Entry;
+}
+
+/*
+ * --------------------------------------------
+ * Encode into a buffer owned by the caller.  Safe to call from several
+ * tasks at once: only type resolution and plan building are serialized,
+ * and each packet is packed from a private copy of its cache entry.
+ * --------------------------------------------
+ */
+CFE_Status_t TO_LAB_EncodeOutputMessageInto(const CFE_SB_Buffer_t *SourceBuffer, void *DestBuffer,
+                                            size_t DestBufferSize, size_t *DestSizeOut)
 {
-    EdsLib_Id_t                           EdsId;
-    EdsLib_DataTypeDB_TypeInfo_t          TypeInfo;
+    TO_LAB_EdsTypeCacheEntry_t           *TypeEntry;
+    TO_LAB_EdsTypeCacheEntry_t            TypeCopy;
     CFE_SB_SoftwareBus_PubSub_Interface_t PubSubParams;
     CFE_SB_Publisher_Component_t          PublisherParams;
     uint16                                TopicId;
     int32                                 EdsStatus;
     CFE_Status_t                          ResultStatus;
     size_t                                SourceBufferSize;
-
-    static EdsPackedBuffer_CFE_HDR_TelemetryHeader_t NetworkBuffer;
+    size_t                                PackedSize;
+    bool                                  IsNewPlan;
+    bool                                  CanUsePlan;
+    bool                                  IsPacked;
 
     const EdsLib_DatabaseObject_t *EDS_DB = CFE_Config_GetObjPointer(CFE_CONFIGID_MISSION_EDS_DB);
 
@@ -63,28 +460,80 @@ CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, con
     CFE_MissionLib_UnmapPublisherComponent(&PublisherParams, &PubSubParams);
     TopicId = PublisherParams.Telemetry.TopicId;
 
-    EdsStatus = CFE_MissionLib_GetArgumentType(&CFE_SOFTWAREBUS_INTERFACE, EDS_INTERFACE_ID(CFE_SB_Telemetry), TopicId,
-                                               1, 1, &EdsId);
-    if (EdsStatus != CFE_MISSIONLIB_SUCCESS)
+    TO_LAB_EncodeLock();
+
+    TypeEntry = TO_LAB_EncodeResolveType(EDS_DB, TopicId);
+    if (TypeEntry == NULL)
     {
+        TO_LAB_EncodeUnlock();
         return CFE_STATUS_UNKNOWN_MSG_ID;
     }
 
-    EdsStatus = EdsLib_DataTypeDB_PackCompleteObject(EDS_DB, &EdsId, NetworkBuffer, SourceBuffer,
-                                                     8 * sizeof(NetworkBuffer), SourceBufferSize);
-    if (EdsStatus != EDSLIB_SUCCESS)
+    PackedSize = (TypeEntry->TypeInfo.Size.Bits + 7) / 8;
+
+    IsNewPlan = (TypeEntry->PlanState == TO_LAB_PackPlanState_NONE);
+    if (IsNewPlan)
     {
-        return CFE_SB_INTERNAL_ERR;
+        TO_LAB_PackPlanBuild(EDS_DB, TypeEntry, SourceBuffer, SourceBufferSize);
     }
 
-    EdsStatus = EdsLib_DataTypeDB_GetTypeInfo(EDS_DB, EdsId, &TypeInfo);
-    if (EdsStatus != EDSLIB_SUCCESS)
+    if (PackedSize > DestBufferSize)
     {
-        return CFE_SB_INTERNAL_ERR;
+        TO_LAB_EncodeUnlock();
+        return CFE_SB_BUFFER_INVALID;
     }
 
-    *DestSizeOut   = (TypeInfo.Size.Bits + 7) / 8;
-    *DestBufferOut = NetworkBuffer;
+    CanUsePlan = (TypeEntry->TypeInfo.Size.Bytes <= SourceBufferSize);
+    IsPacked   = false;
+
+    /* Every plan is checked when built and on its first packet; optionally on all of them */
+    if ((IsNewPlan || TO_LAB_PACK_PLAN_VERIFY) && TypeEntry->PlanState == TO_LAB_PackPlanState_READY && CanUsePlan)
+    {
+        TO_LAB_PackPlanExecute(TypeEntry, SourceBuffer, DestBuffer);
+        TO_LAB_PackPlanVerify(EDS_DB, TypeEntry, SourceBuffer, SourceBufferSize, DestBuffer);
+        IsPacked = (TypeEntry->PlanState == TO_LAB_PackPlanState_READY);
+    }
+
+    TypeCopy = *TypeEntry;
+
+    TO_LAB_EncodeUnlock();
+
+    if (!IsPacked && TypeCopy.PlanState == TO_LAB_PackPlanState_READY && CanUsePlan)
+    {
+        TO_LAB_PackPlanExecute(&TypeCopy, SourceBuffer, DestBuffer);
+        IsPacked = true;
+    }
+
+    if (!IsPacked)
+    {
+        EdsStatus = TO_LAB_PackGeneric(EDS_DB, &TypeCopy, SourceBuffer, SourceBufferSize, DestBuffer, DestBufferSize);
+        if (EdsStatus != EDSLIB_SUCCESS)
+        {
+            return CFE_SB_INTERNAL_ERR;
+        }
+    }
+
+    *DestSizeOut = PackedSize;
 
     return CFE_SUCCESS;
 }
+
+/*
+ * --------------------------------------------
+ * The packed form always differs from the native one, so it is built in
+ * the caller's scratch buffer.
+ * --------------------------------------------
+ */
+CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, void *ScratchBuffer,
+                                        size_t ScratchSize, const void **DestBufferOut, size_t *DestSizeOut)
+{
+    CFE_Status_t ResultStatus;
+
+    ResultStatus = TO_LAB_EncodeOutputMessageInto(SourceBuffer, ScratchBuffer, ScratchSize, DestSizeOut);
+    if (ResultStatus == CFE_SUCCESS)
+    {
+        *DestBufferOut = ScratchBuffer;
+    }
+
+    return ResultStatus;
+}
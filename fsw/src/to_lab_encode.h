@@ -33,8 +33,31 @@
 /*
 ** Prototypes Section
 */
-CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, const void **DestBufferOut,
-                                        size_t *DestSizeOut);
+CFE_Status_t TO_LAB_EncodeInit(void);
+
+/**
+ * @brief Encode a packet, using caller storage if a copy is needed
+ *
+ * The encoder keeps no output buffer of its own.  On success *DestBufferOut
+ * points either at SourceBuffer itself (when the wire format is the native
+ * one) or into ScratchBuffer, and is valid for as long as both of those are.
+ * Fails with CFE_SB_BUFFER_INVALID if the encoded form needs more than
+ * ScratchSize bytes.
+ */
+CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, void *ScratchBuffer,
+                                        size_t ScratchSize, const void **DestBufferOut, size_t *DestSizeOut);
+
+/**
+ * @brief Encode a packet into a buffer owned by the caller
+ *
+ * Always writes the encoded form to DestBuffer and sets *DestSizeOut to the
+ * number of bytes written.  Fails with CFE_SB_BUFFER_INVALID if it needs
+ * more than DestBufferSize bytes.  May be called from several tasks at once.
+ */
+CFE_Status_t TO_LAB_EncodeOutputMessageInto(const CFE_SB_Buffer_t *SourceBuffer, void *DestBuffer,
+                                            size_t DestBufferSize, size_t *DestSizeOut);
+
+void TO_LAB_EncodeInvalidateCache(void);
 
 /******************************************************************************/
 
@@ -0,0 +1,266 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the parallel encode workers of the TO lab application
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_encode.h"
+#include "to_lab_encode_pool.h"
+#include "to_lab_eventids.h"
+#include "to_lab_perfids.h"
+
+/*
+ * Slot state is shared between tasks; see the note in to_lab_sender.c
+ * about the atomic builtins.
+ */
+static inline uint32 TO_LAB_EncodePoolLoad(const uint32 *Value)
+{
+    return __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+}
+
+static inline void TO_LAB_EncodePoolStore(uint32 *Value, uint32 NewValue)
+{
+    __atomic_store_n(Value, NewValue, __ATOMIC_RELEASE);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EncodePoolInit() -- Start the encode workers             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_EncodePoolInit(void)
+{
+    TO_LAB_EncodePool_t *Pool = &TO_LAB_Global.EncodePool;
+    CFE_ES_TaskId_t      TaskId;
+    char                 TaskName[OS_MAX_API_NAME];
+    int32                status;
+    uint16               NumWorkers;
+    uint16               i;
+
+    status = OS_CountSemCreate(&Pool->WorkSem, "TO_LAB_ENC_WORK", 0, 0);
+    if (status == OS_SUCCESS)
+    {
+        status = OS_CountSemCreate(&Pool->DoneSem, "TO_LAB_ENC_DONE", 0, 0);
+    }
+
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_ENCODER_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't create encode semaphores status %i", __LINE__, (int)status);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    /* Not compared against the macro directly, which may be 0 */
+    NumWorkers = TO_LAB_ENCODE_WORKERS;
+    for (i = 0; i < NumWorkers; i++)
+    {
+        snprintf(TaskName, sizeof(TaskName), "TO_LAB_ENC_%u", (unsigned int)i);
+
+        status = CFE_ES_CreateChildTask(&TaskId, TaskName, TO_LAB_EncodeWorkerTask, NULL,
+                                        TO_LAB_ENCODE_WORKER_STACK_SIZE, TO_LAB_ENCODE_WORKER_PRIORITY, 0);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(TO_LAB_ENCODER_ERR_EID, CFE_EVS_EventType_ERROR,
+                              "L%d TO Can't create encode worker %u status %i", __LINE__, (unsigned int)i,
+                              (int)status);
+            break;
+        }
+
+        /* Any one worker is enough to make progress */
+        Pool->Running = true;
+    }
+
+    return Pool->Running ? CFE_SUCCESS : status;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EncodeWorkerTask() -- Encode queued packets              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_EncodeWorkerTask(void)
+{
+    TO_LAB_EncodePool_t *Pool = &TO_LAB_Global.EncodePool;
+    TO_LAB_EncodeSlot_t *Slot;
+    OS_time_t            StartTime;
+    OS_time_t            EndTime;
+    uint32               Claim;
+
+    while (OS_CountSemTake(Pool->WorkSem) == OS_SUCCESS)
+    {
+        /* One claim per semaphore count, so the slot is always a submitted one */
+        Claim = __atomic_fetch_add(&Pool->Claimed, 1, __ATOMIC_ACQ_REL);
+        Slot  = &Pool->Slot[Claim % TO_LAB_ENCODE_QUEUE_DEPTH];
+
+        OS_GetLocalTime(&StartTime);
+
+        Slot->Status =
+            TO_LAB_EncodeOutputMessageInto(Slot->Input, Slot->Output, Slot->OutputCapacity, &Slot->OutputSize);
+
+        OS_GetLocalTime(&EndTime);
+        Slot->EncodeUsec = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+
+        TO_LAB_EncodePoolStore(&Slot->Done, true);
+        OS_CountSemGive(Pool->DoneSem);
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EncodePoolSubmit() -- Queue a packet for the workers     */
+/*                                                                 */
+/* Returns false if the caller must encode the packet itself:      */
+/* there are no workers, or no slab buffers can be had for it.  In */
+/* the latter case every packet already queued is written out      */
+/* first, so order is kept.                                        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_EncodePoolSubmit(TO_LAB_Channel_t *Chan, TO_LAB_Stream_t *Stream, CFE_SB_MsgId_t MsgId, uint32 PayloadHash,
+                             CFE_TIME_SysTime_t PktTime, const CFE_SB_Buffer_t *SBBufPtr)
+{
+    TO_LAB_EncodePool_t *Pool = &TO_LAB_Global.EncodePool;
+    TO_LAB_EncodeSlot_t *Slot;
+    CFE_MSG_Size_t       MsgSize;
+    void                *Input;
+    void                *Output;
+    uint32               InUse;
+
+    if (!Pool->Running)
+    {
+        return false;
+    }
+
+    if (CFE_MSG_GetSize(&SBBufPtr->Msg, &MsgSize) != CFE_SUCCESS)
+    {
+        TO_LAB_EncodePoolCollect(true);
+        ++TO_LAB_Global.HkTlm.Payload.EncodeInlineCount;
+        return false;
+    }
+
+    /* Write out whatever is finished, and make room if every slot is busy */
+    TO_LAB_EncodePoolCollect(false);
+    while ((Pool->Submitted - Pool->Collected) >= TO_LAB_ENCODE_QUEUE_DEPTH)
+    {
+        OS_CountSemTimedWait(Pool->DoneSem, TO_LAB_ENCODE_WAIT_MSEC);
+        TO_LAB_EncodePoolCollect(false);
+    }
+
+    /* The encoded form is never larger than the native packet */
+    Input  = TO_LAB_SlabAlloc(MsgSize);
+    Output = (Input != NULL) ? TO_LAB_SlabAlloc(MsgSize) : NULL;
+
+    if (Output == NULL && Pool->Submitted != Pool->Collected)
+    {
+        /* The buffers are held by packets still queued; wait for them */
+        if (Input != NULL)
+        {
+            TO_LAB_SlabFree(Input);
+        }
+
+        TO_LAB_EncodePoolCollect(true);
+
+        Input  = TO_LAB_SlabAlloc(MsgSize);
+        Output = (Input != NULL) ? TO_LAB_SlabAlloc(MsgSize) : NULL;
+    }
+
+    if (Output == NULL)
+    {
+        if (Input != NULL)
+        {
+            TO_LAB_SlabFree(Input);
+        }
+
+        ++TO_LAB_Global.HkTlm.Payload.EncodeInlineCount;
+        return false;
+    }
+
+    Slot                 = &Pool->Slot[Pool->Submitted % TO_LAB_ENCODE_QUEUE_DEPTH];
+    Slot->Chan           = Chan;
+    Slot->Stream         = Stream;
+    Slot->MsgId          = MsgId;
+    Slot->PayloadHash    = PayloadHash;
+    Slot->PktTime        = PktTime;
+    Slot->Done           = false;
+    Slot->Input          = Input;
+    Slot->Output         = Output;
+    Slot->OutputCapacity = MsgSize;
+    memcpy(Input, SBBufPtr, MsgSize);
+
+    ++Pool->Submitted;
+    OS_CountSemGive(Pool->WorkSem);
+
+    InUse = Pool->Submitted - Pool->Collected;
+    if (InUse > Pool->HighWater)
+    {
+        Pool->HighWater = InUse;
+    }
+
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_EncodePoolCollect() -- Write out finished packets        */
+/*                                                                 */
+/* Stops at the oldest packet still being encoded, unless WaitAll  */
+/* is set, in which case it waits for every queued packet.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_EncodePoolCollect(bool WaitAll)
+{
+    TO_LAB_EncodePool_t *Pool = &TO_LAB_Global.EncodePool;
+    TO_LAB_EncodeSlot_t *Slot;
+
+    while (Pool->Collected != Pool->Submitted)
+    {
+        Slot = &Pool->Slot[Pool->Collected % TO_LAB_ENCODE_QUEUE_DEPTH];
+
+        if (!TO_LAB_EncodePoolLoad(&Slot->Done))
+        {
+            if (!WaitAll)
+            {
+                break;
+            }
+
+            OS_CountSemTimedWait(Pool->DoneSem, TO_LAB_ENCODE_WAIT_MSEC);
+            continue;
+        }
+
+        TO_LAB_HistogramAdd(&TO_LAB_Global.HkExtTlm.Payload.EncodeUsec, Slot->EncodeUsec);
+
+        CFE_ES_PerfLogEntry(TO_LAB_SOCKET_SEND_PERF_ID);
+        TO_LAB_output_encoded(Slot->Chan, Slot->Stream, Slot->MsgId, Slot->PayloadHash, Slot->PktTime, Slot->Status,
+                              Slot->Output, Slot->OutputSize);
+        CFE_ES_PerfLogExit(TO_LAB_SOCKET_SEND_PERF_ID);
+
+        TO_LAB_SlabFree(Slot->Input);
+        TO_LAB_SlabFree(Slot->Output);
+
+        ++Pool->Collected;
+    }
+}
@@ -0,0 +1,103 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Parallel encode workers of the TO lab application
+ *
+ * When TO_LAB_ENCODE_WORKERS is non-zero, the main task copies each packet
+ * to be forwarded into a slot of a fixed work queue instead of encoding it.
+ * Worker child tasks claim queued slots, encode them into the slot's own
+ * output buffer and mark them done.  The main task collects finished slots
+ * strictly in submission order and writes them to their channel, so output
+ * order, and so per-MsgId order, is exactly what it would be without
+ * workers.  Slot buffers come from the slab pool (see to_lab_slab.h).
+ *
+ * This pays off with the EDS encoder, where packing dominates the cost of
+ * each packet.  The passthru encoder costs no more than the copy into the
+ * queue, so workers only add overhead there.
+ */
+
+#ifndef TO_LAB_ENCODE_POOL_H
+#define TO_LAB_ENCODE_POOL_H
+
+#include "common_types.h"
+#include "osapi.h"
+#include "cfe_es.h"
+#include "cfe_sb.h"
+
+#include "to_lab_platform_cfg.h"
+#include "to_lab_output.h"
+#include "to_lab_streams.h"
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * One packet in the encode work queue
+ */
+typedef struct
+{
+    uint32 Done; /**< Set by the worker once Status and Output are valid */
+
+    TO_LAB_Channel_t  *Chan;
+    TO_LAB_Stream_t   *Stream;
+    CFE_SB_MsgId_t     MsgId;
+    uint32             PayloadHash; /**< From TO_LAB_StreamChangedPass(), committed once written */
+    CFE_TIME_SysTime_t PktTime;     /**< Packet timestamp, or zero if it has none */
+
+    CFE_Status_t Status;     /**< Result of encoding */
+    size_t       OutputSize; /**< Encoded size, valid if Status is CFE_SUCCESS */
+    uint32       EncodeUsec; /**< Time the worker spent encoding */
+
+    CFE_SB_Buffer_t *Input;          /**< Copy of the packet as received from SB, from the slab pool */
+    void            *Output;         /**< Encoded packet, from the slab pool */
+    size_t           OutputCapacity; /**< Size of Output */
+} TO_LAB_EncodeSlot_t;
+
+/**
+ * Encode worker state
+ *
+ * Slots are used in order.  The main task advances Submitted and
+ * Collected; workers share Claimed.
+ */
+typedef struct
+{
+    uint32              Submitted; /**< Slots handed to the workers */
+    uint32              Claimed;   /**< Slots taken by a worker */
+    uint32              Collected; /**< Slots written out and free again */
+    osal_id_t           WorkSem;   /**< Counts submitted slots not yet claimed */
+    osal_id_t           DoneSem;   /**< Given each time a worker finishes a slot */
+    bool                Running;   /**< Workers were created */
+    uint16              HighWater; /**< Most slots in use at once since reset */
+    TO_LAB_EncodeSlot_t Slot[TO_LAB_ENCODE_QUEUE_DEPTH];
+} TO_LAB_EncodePool_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+int32 TO_LAB_EncodePoolInit(void);
+void  TO_LAB_EncodeWorkerTask(void);
+bool  TO_LAB_EncodePoolSubmit(TO_LAB_Channel_t *Chan, TO_LAB_Stream_t *Stream, CFE_SB_MsgId_t MsgId,
+                              uint32 PayloadHash, CFE_TIME_SysTime_t PktTime, const CFE_SB_Buffer_t *SBBufPtr);
+void  TO_LAB_EncodePoolCollect(bool WaitAll);
+
+#endif
@@ -0,0 +1,73 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the log2 histograms of the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_histogram.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_HistogramAdd() -- Count one sample                       */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_HistogramAdd(TO_LAB_Histogram_t *Hist, uint32 Value)
+{
+    uint32 BucketIdx = 0;
+
+    /* Bucket index is the number of significant bits in Value */
+    while (Value != 0 && BucketIdx < (TO_LAB_HIST_BUCKETS - 1))
+    {
+        Value >>= 1;
+        ++BucketIdx;
+    }
+
+    ++Hist->Bucket[BucketIdx];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_HistogramAddUsecSince() -- Count microseconds elapsed   */
+/*                                   since StartTime               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_HistogramAddUsecSince(TO_LAB_Histogram_t *Hist, OS_time_t StartTime)
+{
+    OS_time_t CurrTime;
+    int64     ElapsedUsec;
+
+    OS_GetLocalTime(&CurrTime);
+    ElapsedUsec = OS_TimeGetTotalMicroseconds(OS_TimeSubtract(CurrTime, StartTime));
+
+    /* Local time stepped backwards, the sample is meaningless */
+    if (ElapsedUsec < 0)
+    {
+        return;
+    }
+
+    if (ElapsedUsec > 0xFFFFFFFF)
+    {
+        ElapsedUsec = 0xFFFFFFFF;
+    }
+
+    TO_LAB_HistogramAdd(Hist, (uint32)ElapsedUsec);
+}
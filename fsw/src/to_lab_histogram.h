@@ -0,0 +1,44 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Log2 histograms for the TO lab forwarding path
+ *
+ * Bucket 0 counts samples of 0; bucket N counts samples from 2^(N-1) up to
+ * 2^N - 1.  The last bucket also takes everything larger.  Adding a sample
+ * is a bit scan and an increment, cheap enough for every forwarded packet.
+ */
+
+#ifndef TO_LAB_HISTOGRAM_H
+#define TO_LAB_HISTOGRAM_H
+
+#include "common_types.h"
+#include "osapi.h"
+
+#include "to_lab_msgdefs.h"
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+void TO_LAB_HistogramAdd(TO_LAB_Histogram_t *Hist, uint32 Value);
+void TO_LAB_HistogramAddUsecSince(TO_LAB_Histogram_t *Hist, OS_time_t StartTime);
+
+#endif
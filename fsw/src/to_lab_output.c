@@ -0,0 +1,866 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the datagram output path for the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_output.h"
+#include "to_lab_eventids.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSocketSend() -- Hand one datagram to the socket    */
+/*                                                                 */
+/* Sends it directly, or queues it for the sender task when that   */
+/* is enabled.                                                     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputSocketSend(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    int32 OsStatus;
+
+    if (TO_LAB_Global.Sender.Running)
+    {
+        OsStatus = TO_LAB_SenderEnqueue(Chan, DataPtr, DataSize);
+    }
+    else
+    {
+        OsStatus = TO_LAB_OutputSendTo(Chan, DataPtr, DataSize);
+    }
+
+    /* The ground cannot expand anything that refers to a lost datagram */
+    if (OsStatus < 0)
+    {
+        Chan->Compress.ResetPending = true;
+    }
+
+    return OsStatus;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputErrorIsTransient() -- Classify a socket send error */
+/*                                                                 */
+/* OSAL reports any failure of the send call itself, ENOBUFS and   */
+/* EAGAIN included, as OS_ERROR; those are worth retrying.  The    */
+/* other codes mean the socket or the request is unusable.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static bool TO_LAB_OutputErrorIsTransient(int32 OsStatus)
+{
+    return (OsStatus == OS_ERROR || OsStatus == OS_ERROR_TIMEOUT || OsStatus == OS_QUEUE_FULL);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSendFailed() -- Stop output after a fatal error    */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_OutputSendFailed(TO_LAB_Channel_t *Chan, int32 OsStatus)
+{
+    CFE_EVS_SendEvent(TO_LAB_TLMOUTSTOP_ERR_EID, CFE_EVS_EventType_ERROR,
+                      "L%d TO sendto error %d. Tlm output suppressed on channel %u\n", __LINE__, (int)OsStatus,
+                      (unsigned int)Chan->ChannelIdx);
+    Chan->suppress_sendto = true;
+
+    TO_LAB_OutputRetryDiscard(Chan);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSendNow() -- Make one socket send call             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static int32 TO_LAB_OutputSendNow(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    int32     OsStatus;
+    OS_time_t SendStart;
+    uint32    StateFlags;
+
+    OS_GetLocalTime(&SendStart);
+    if (Chan->Connected)
+    {
+        /* OSAL has no send() for sockets; a plain write on a connected socket is the same call */
+        if (TO_LAB_NONBLOCKING_OUTPUT)
+        {
+            /* A write the socket cannot take now would block the whole app */
+            OsStatus = OS_TimedWrite(Chan->TLMsockid, DataPtr, DataSize, 0);
+        }
+        else
+        {
+            OsStatus = OS_write(Chan->TLMsockid, DataPtr, DataSize);
+        }
+    }
+    else
+    {
+        OsStatus = OS_SocketSendTo(Chan->TLMsockid, DataPtr, DataSize, &Chan->DestAddr);
+    }
+    TO_LAB_HistogramAddUsecSince(&TO_LAB_Global.HkExtTlm.Payload.SendUsec, SendStart);
+
+    if (TO_LAB_NONBLOCKING_OUTPUT && OsStatus == OS_ERROR)
+    {
+        /* A full socket fails sendto with EAGAIN, which OSAL reports as OS_ERROR */
+        StateFlags = OS_STREAM_STATE_WRITABLE;
+        if (OS_SelectSingle(Chan->TLMsockid, &StateFlags, 0) != OS_SUCCESS ||
+            (StateFlags & OS_STREAM_STATE_WRITABLE) == 0)
+        {
+            OsStatus = TO_LAB_SEND_WOULD_BLOCK;
+        }
+    }
+
+    if (TO_LAB_NONBLOCKING_OUTPUT && OsStatus == TO_LAB_SEND_WOULD_BLOCK)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendWouldBlockCount;
+        return TO_LAB_SEND_WOULD_BLOCK;
+    }
+
+    if (OsStatus >= 0)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.TlmDatagramCount;
+    }
+    else if (TO_LAB_OutputErrorIsTransient(OsStatus))
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendTransientErrors;
+    }
+    else
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendFatalErrors;
+    }
+
+    return OsStatus;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputRetryQueue() -- Keep a datagram for a later retry  */
+/*                                                                 */
+/* OsStatus is why it was not sent; a datagram that would only     */
+/* have blocked may go as soon as the socket is writable.  Returns */
+/* DataSize if it was kept, OS_QUEUE_FULL if dropped.              */
+/*                                                                 */
+/* The Tag of a kept datagram is set if its own send failed, not   */
+/* if it only waits on the socket or on the datagrams before it.   */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static int32 TO_LAB_OutputRetryQueue(TO_LAB_Channel_t *Chan, int32 OsStatus, const void *DataPtr, size_t DataSize)
+{
+    TO_LAB_SendRetry_t *Retry = &Chan->Retry;
+    TO_LAB_HeldBuf_t   *Held;
+    void               *HeldPtr;
+    OS_time_t           CurrTime;
+
+    /* Without retries, only datagrams waiting for a non-blocking socket are kept */
+    if (!TO_LAB_SEND_RETRY_ENABLE && !(TO_LAB_NONBLOCKING_OUTPUT && OsStatus == TO_LAB_SEND_WOULD_BLOCK))
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendRetryDropCount;
+        return OS_QUEUE_FULL;
+    }
+
+    HeldPtr = TO_LAB_HoldAcquire(&Retry->Ring, DataSize);
+    if (HeldPtr == NULL)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendRetryDropCount;
+        return OS_QUEUE_FULL;
+    }
+
+    memcpy(HeldPtr, DataPtr, DataSize);
+    Held      = &Retry->Ring.Entry[(Retry->Ring.Head + Retry->Ring.Count - 1) % Retry->Ring.Depth];
+    Held->Tag = (OsStatus != TO_LAB_SEND_WOULD_BLOCK);
+
+    if (Retry->Ring.Count == 1)
+    {
+        /* First datagram of a new run of errors, start the backoff over */
+        OS_GetLocalTime(&CurrTime);
+        Retry->Attempts    = 0;
+        Retry->BackoffMsec = TO_LAB_SEND_RETRY_MIN_MSEC;
+        Retry->NextTime    = CurrTime;
+        if (OsStatus != TO_LAB_SEND_WOULD_BLOCK)
+        {
+            Retry->NextTime = OS_TimeAdd(CurrTime, OS_TimeFromTotalMilliseconds(Retry->BackoffMsec));
+        }
+    }
+
+    return (int32)DataSize;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputRetry() -- Resend datagrams kept after an error    */
+/*                                                                 */
+/* Nothing is attempted until the current backoff has passed.  A   */
+/* datagram that fails TO_LAB_SEND_RETRY_LIMIT times in a row is   */
+/* treated as a fatal error.  Only datagrams whose own send failed */
+/* are counted in SendRetryCount once they go out.                 */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputRetry(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_SendRetry_t *Retry = &Chan->Retry;
+    TO_LAB_HeldBuf_t   *Held;
+    OS_time_t           CurrTime;
+    int32               OsStatus;
+
+    if (Retry->Ring.Count == 0 || !Chan->downlink_on || Chan->suppress_sendto)
+    {
+        return;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+    if (OS_TimeGetTotalMilliseconds(OS_TimeSubtract(Retry->NextTime, CurrTime)) > 0)
+    {
+        return;
+    }
+
+    while (Retry->Ring.Count != 0)
+    {
+        Held     = &Retry->Ring.Entry[Retry->Ring.Head];
+        OsStatus = TO_LAB_OutputSendNow(Chan, &Retry->Ring.Data[Held->Offset], Held->Size);
+
+        if (OsStatus >= 0)
+        {
+            if (Held->Tag != 0)
+            {
+                ++TO_LAB_Global.HkTlm.Payload.SendRetryCount;
+            }
+            TO_LAB_HoldRelease(&Retry->Ring);
+            Retry->Attempts    = 0;
+            Retry->BackoffMsec = TO_LAB_SEND_RETRY_MIN_MSEC;
+        }
+        else if (OsStatus == TO_LAB_SEND_WOULD_BLOCK)
+        {
+            /* Not an error, try again once the socket is writable */
+            break;
+        }
+        else if (TO_LAB_OutputErrorIsTransient(OsStatus) && ++Retry->Attempts < TO_LAB_SEND_RETRY_LIMIT)
+        {
+            Held->Tag = 1;
+            Retry->BackoffMsec *= 2;
+            if (Retry->BackoffMsec > TO_LAB_SEND_RETRY_MAX_MSEC)
+            {
+                Retry->BackoffMsec = TO_LAB_SEND_RETRY_MAX_MSEC;
+            }
+            Retry->NextTime = OS_TimeAdd(CurrTime, OS_TimeFromTotalMilliseconds(Retry->BackoffMsec));
+            break;
+        }
+        else
+        {
+            TO_LAB_OutputSendFailed(Chan, OsStatus);
+            break;
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputFlushPending() -- Send kept datagrams as the       */
+/*                                socket becomes writable          */
+/*                                                                 */
+/* Waits for the socket, but never past Deadline, and not while    */
+/* backing off after an error.                                     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputFlushPending(TO_LAB_Channel_t *Chan, OS_time_t Deadline)
+{
+    OS_time_t CurrTime;
+    int64     RemainMsec;
+    uint32    StateFlags;
+    uint32    Count;
+
+    while (Chan->Retry.Ring.Count != 0 && Chan->downlink_on && !Chan->suppress_sendto)
+    {
+        OS_GetLocalTime(&CurrTime);
+        RemainMsec = OS_TimeGetTotalMilliseconds(OS_TimeSubtract(Deadline, CurrTime));
+
+        if (RemainMsec <= 0 || OS_TimeGetTotalMilliseconds(OS_TimeSubtract(Chan->Retry.NextTime, CurrTime)) > 0)
+        {
+            break;
+        }
+
+        StateFlags = OS_STREAM_STATE_WRITABLE;
+        if (OS_SelectSingle(Chan->TLMsockid, &StateFlags, (int32)RemainMsec) != OS_SUCCESS ||
+            (StateFlags & OS_STREAM_STATE_WRITABLE) == 0)
+        {
+            break;
+        }
+
+        Count = Chan->Retry.Ring.Count;
+        TO_LAB_OutputRetry(Chan);
+
+        if (Chan->Retry.Ring.Count == Count)
+        {
+            break;
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputRetryDiscard() -- Drop datagrams kept for a retry  */
+/*                                                                 */
+/* Only call this while no other task can be sending on Chan       */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputRetryDiscard(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_Global.HkTlm.Payload.SendRetryDropCount += Chan->Retry.Ring.Count;
+
+    while (Chan->Retry.Ring.Count != 0)
+    {
+        TO_LAB_HoldRelease(&Chan->Retry.Ring);
+    }
+
+    Chan->Retry.Attempts = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSendTo() -- Send one datagram to the socket now    */
+/*                                                                 */
+/* A transient error, or a socket that is not writable in          */
+/* non-blocking mode, keeps the datagram for TO_LAB_OutputRetry(), */
+/* and so does anything sent while earlier datagrams are waiting   */
+/* for a retry, so the order on the wire is kept.  Returns         */
+/* DataSize for a datagram kept that way.                          */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputSendTo(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    int32 OsStatus;
+
+    if (Chan->Retry.Ring.Count != 0)
+    {
+        TO_LAB_OutputRetry(Chan);
+
+        if (Chan->suppress_sendto)
+        {
+            return OS_ERROR;
+        }
+
+        if (Chan->Retry.Ring.Count != 0)
+        {
+            return TO_LAB_OutputRetryQueue(Chan, TO_LAB_SEND_WOULD_BLOCK, DataPtr, DataSize);
+        }
+    }
+
+    OsStatus = TO_LAB_OutputSendNow(Chan, DataPtr, DataSize);
+
+    if (OsStatus < 0)
+    {
+        if (OsStatus == TO_LAB_SEND_WOULD_BLOCK || TO_LAB_OutputErrorIsTransient(OsStatus))
+        {
+            OsStatus = TO_LAB_OutputRetryQueue(Chan, OsStatus, DataPtr, DataSize);
+        }
+        else
+        {
+            TO_LAB_OutputSendFailed(Chan, OsStatus);
+        }
+    }
+
+    return OsStatus;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_HoldInit() -- Set up an empty hold ring on its storage   */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_HoldInit(TO_LAB_HoldRing_t *Ring, TO_LAB_HeldBuf_t *Entry, size_t EntryBytes, uint8 *Data,
+                     size_t DataSize)
+{
+    memset(Ring, 0, sizeof(*Ring));
+
+    Ring->Entry    = Entry;
+    Ring->Depth    = (uint32)(EntryBytes / sizeof(*Entry));
+    Ring->Data     = Data;
+    Ring->DataSize = DataSize;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_HoldAcquire() -- Reserve space for a held datagram       */
+/*                                                                 */
+/* Returns NULL if the ring cannot hold DataSize more bytes        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void *TO_LAB_HoldAcquire(TO_LAB_HoldRing_t *Ring, size_t DataSize)
+{
+    TO_LAB_HeldBuf_t *Held;
+    size_t            DataHead;
+    size_t            Offset;
+
+    if (DataSize == 0 || Ring->Count >= Ring->Depth)
+    {
+        return NULL;
+    }
+
+    if (Ring->Count == 0)
+    {
+        Offset = 0;
+        if (DataSize > Ring->DataSize)
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        DataHead = Ring->Entry[Ring->Head].Offset;
+
+        if (Ring->DataTail > DataHead)
+        {
+            /* Free space is after the tail and, by wrapping, before the head */
+            if ((Ring->DataSize - Ring->DataTail) >= DataSize)
+            {
+                Offset = Ring->DataTail;
+            }
+            else if (DataHead >= DataSize)
+            {
+                Offset = 0;
+            }
+            else
+            {
+                return NULL;
+            }
+        }
+        else if ((DataHead - Ring->DataTail) >= DataSize)
+        {
+            Offset = Ring->DataTail;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+
+    Held         = &Ring->Entry[(Ring->Head + Ring->Count) % Ring->Depth];
+    Held->Offset = Offset;
+    Held->Size   = DataSize;
+    Held->Tag    = 0;
+
+    Ring->DataTail = Offset + DataSize;
+    ++Ring->Count;
+
+    if (Ring->Count > Ring->HighWater)
+    {
+        Ring->HighWater = Ring->Count;
+    }
+
+    return &Ring->Data[Offset];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_HoldRelease() -- Release the oldest held datagram        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_HoldRelease(TO_LAB_HoldRing_t *Ring)
+{
+    if (Ring->Count == 0)
+    {
+        return;
+    }
+
+    Ring->Head = (Ring->Head + 1) % Ring->Depth;
+    --Ring->Count;
+
+    if (Ring->Count == 0)
+    {
+        Ring->Head     = 0;
+        Ring->DataTail = 0;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSubmitVector() -- Send all held datagrams          */
+/*                                                                 */
+/* OSAL offers no multi-datagram send (sendmmsg or similar), so    */
+/* this backend submits the entries one OS_SocketSendTo() at a     */
+/* time.  A platform with a vectored send replaces only this loop. */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputSubmitVector(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_HoldRing_t *Ring = &Chan->HoldRing;
+    TO_LAB_HeldBuf_t  *Held;
+
+    while (Ring->Count != 0)
+    {
+        Held = &Ring->Entry[Ring->Head];
+
+        if (!Chan->suppress_sendto)
+        {
+            TO_LAB_OutputSocketSend(Chan, &Ring->Data[Held->Offset], Held->Size);
+        }
+
+        /* Send has completed (or output is suppressed), the buffer can be reused */
+        TO_LAB_HoldRelease(Ring);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputSendDatagram() -- Send or hold one datagram        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputSendDatagram(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    void     *HeldPtr;
+    size_t    CompressedSize;
+    OS_time_t CompressStart;
+    OS_time_t CompressEnd;
+
+    if (Chan->Compress.Enabled)
+    {
+        OS_GetLocalTime(&CompressStart);
+        CompressedSize = TO_LAB_CompressDatagram(&Chan->Compress, DataPtr, DataSize);
+        OS_GetLocalTime(&CompressEnd);
+
+        if (CompressedSize != 0)
+        {
+            TO_LAB_Global.HkTlm.Payload.CompressInBytes += DataSize;
+            TO_LAB_Global.HkTlm.Payload.CompressOutBytes += CompressedSize;
+            TO_LAB_Global.HkTlm.Payload.CompressUsec +=
+                (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(CompressEnd, CompressStart));
+
+            DataPtr  = Chan->Compress.Output;
+            DataSize = CompressedSize;
+        }
+    }
+
+    if (!TO_LAB_VECTOR_SEND_ENABLE)
+    {
+        return TO_LAB_OutputSocketSend(Chan, DataPtr, DataSize);
+    }
+
+    HeldPtr = TO_LAB_HoldAcquire(&Chan->HoldRing, DataSize);
+    if (HeldPtr == NULL)
+    {
+        /* Ring is full (or the datagram is larger than the ring), submit what is held */
+        TO_LAB_OutputSubmitVector(Chan);
+        HeldPtr = TO_LAB_HoldAcquire(&Chan->HoldRing, DataSize);
+    }
+
+    if (HeldPtr == NULL)
+    {
+        return TO_LAB_OutputSocketSend(Chan, DataPtr, DataSize);
+    }
+
+    memcpy(HeldPtr, DataPtr, DataSize);
+
+    return OS_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputFlush() -- Send the partially filled batch, if any */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputFlush(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_Batch_t *Batch = &Chan->Batch;
+
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        TO_LAB_TcpService(Chan, true);
+        return;
+    }
+
+    if (Batch->FrameCount == 0)
+    {
+        return;
+    }
+
+    Batch->Buffer[3] = Batch->FrameCount;
+
+    if (!Chan->suppress_sendto)
+    {
+        TO_LAB_OutputSendDatagram(Chan, Batch->Buffer, Batch->Size);
+    }
+
+    Batch->FrameCount = 0;
+    Batch->Size       = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputWrite() -- Send or batch one encoded packet        */
+/*                                                                 */
+/* Returns OS_SUCCESS if the packet was sent or queued to be sent, */
+/* or the error it was dropped on                                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputWrite(TO_LAB_Channel_t *Chan, const void *NetBufPtr, size_t NetBufSize)
+{
+    TO_LAB_Batch_t *Batch = &Chan->Batch;
+    uint8          *FramePtr;
+    int32           OsStatus;
+
+    /* A stream has its own framing and coalescing */
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        return TO_LAB_TcpWrite(Chan, NetBufPtr, NetBufSize);
+    }
+
+    if (!TO_LAB_BATCH_ENABLE ||
+        NetBufSize > (TO_LAB_BATCH_MTU - TO_LAB_BATCH_HDR_SIZE - TO_LAB_BATCH_LENGTH_SIZE))
+    {
+        /* Keep datagram order: anything already batched goes first */
+        TO_LAB_OutputFlush(Chan);
+        OsStatus = TO_LAB_OutputSendDatagram(Chan, NetBufPtr, NetBufSize);
+
+        return (OsStatus < 0) ? OsStatus : OS_SUCCESS;
+    }
+
+    if (Batch->FrameCount >= TO_LAB_BATCH_MAX_FRAMES ||
+        (Batch->Size + TO_LAB_BATCH_LENGTH_SIZE + NetBufSize) > TO_LAB_BATCH_MTU)
+    {
+        TO_LAB_OutputFlush(Chan);
+    }
+
+    if (Batch->FrameCount == 0)
+    {
+        Batch->Buffer[0] = TO_LAB_BATCH_MAGIC_0;
+        Batch->Buffer[1] = TO_LAB_BATCH_MAGIC_1;
+        Batch->Buffer[2] = TO_LAB_BATCH_VERSION;
+        Batch->Buffer[3] = 0;
+        Batch->Size      = TO_LAB_BATCH_HDR_SIZE;
+        OS_GetLocalTime(&Batch->StartTime);
+    }
+
+    FramePtr    = &Batch->Buffer[Batch->Size];
+    FramePtr[0] = (uint8)(NetBufSize >> 8);
+    FramePtr[1] = (uint8)NetBufSize;
+    memcpy(&FramePtr[TO_LAB_BATCH_LENGTH_SIZE], NetBufPtr, NetBufSize);
+
+    Batch->Size += TO_LAB_BATCH_LENGTH_SIZE + NetBufSize;
+    ++Batch->FrameCount;
+
+    return OS_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputDeferredCount() -- Deferred packet counter of a    */
+/*                                 rate limit stream               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static uint16 *TO_LAB_OutputDeferredCount(TO_LAB_Channel_t *Chan, uint16 StreamIdx)
+{
+    if (StreamIdx == TO_LAB_RATE_NO_STREAM)
+    {
+        return &Chan->RateLimit.NoStreamDeferred;
+    }
+
+    return &Chan->RateLimit.Stream[StreamIdx].DeferredCount;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputLimitedWrite() -- Send one encoded packet, subject */
+/*                                to the channel's rate limits     */
+/*                                                                 */
+/* A packet over its limits is copied to the deferral queue.  So   */
+/* that a stream's packets stay in order, a packet is also         */
+/* deferred while earlier packets of its stream are waiting.       */
+/*                                                                 */
+/* Returns the TO_LAB_OutputWrite() status of a packet written,    */
+/* TO_LAB_OUTPUT_DEFERRED or TO_LAB_OUTPUT_DEFER_DROPPED           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputLimitedWrite(TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t MsgId, CFE_TIME_SysTime_t PktTime,
+                                const void *NetBufPtr, size_t NetBufSize)
+{
+    TO_LAB_HoldRing_t *Ring = &Chan->DeferRing;
+    TO_LAB_HeldBuf_t  *Held;
+    uint16             StreamIdx;
+    uint16            *DeferredCount;
+    void              *DeferPtr;
+
+    StreamIdx     = TO_LAB_RateLimitFindStream(&Chan->RateLimit, MsgId);
+    DeferredCount = TO_LAB_OutputDeferredCount(Chan, StreamIdx);
+
+    if (*DeferredCount == 0 && TO_LAB_RateLimitAdmit(&Chan->RateLimit, StreamIdx))
+    {
+        TO_LAB_RateLimitCharge(&Chan->RateLimit, StreamIdx, NetBufSize);
+        return TO_LAB_OutputWrite(Chan, NetBufPtr, NetBufSize);
+    }
+
+    DeferPtr = TO_LAB_HoldAcquire(Ring, NetBufSize);
+    if (DeferPtr == NULL)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.TlmDeferDropCount;
+        return TO_LAB_OUTPUT_DEFER_DROPPED;
+    }
+
+    memcpy(DeferPtr, NetBufPtr, NetBufSize);
+    Held        = &Ring->Entry[(Ring->Head + Ring->Count - 1) % Ring->Depth];
+    Held->Tag     = StreamIdx;
+    Held->MsgId   = MsgId;
+    Held->PktTime = PktTime;
+    ++*DeferredCount;
+
+    ++TO_LAB_Global.HkTlm.Payload.TlmDeferredCount;
+
+    return TO_LAB_OUTPUT_DEFERRED;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputReleaseDeferred() -- Send deferred packets as the  */
+/*                                   rate limits allow             */
+/*                                                                 */
+/* Packets leave in arrival order; the oldest one waiting on its   */
+/* stream's limit holds back those behind it.  Each is counted as  */
+/* forwarded, and its latency recorded, once it is written.        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputReleaseDeferred(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_HoldRing_t *Ring = &Chan->DeferRing;
+    TO_LAB_HeldBuf_t  *Held;
+    TO_LAB_Stream_t   *Stream;
+    int32              OsStatus;
+
+    if (!Chan->downlink_on || Chan->suppress_sendto)
+    {
+        return;
+    }
+
+    while (Ring->Count != 0)
+    {
+        Held = &Ring->Entry[Ring->Head];
+
+        if (!TO_LAB_RateLimitAdmit(&Chan->RateLimit, Held->Tag))
+        {
+            break;
+        }
+
+        TO_LAB_RateLimitCharge(&Chan->RateLimit, Held->Tag, Held->Size);
+        OsStatus = TO_LAB_OutputWrite(Chan, &Ring->Data[Held->Offset], Held->Size);
+        Stream   = TO_LAB_StreamLookup(Held->MsgId);
+
+        if (OsStatus == OS_SUCCESS)
+        {
+            ++TO_LAB_Global.HkTlm.Payload.TlmForwardedCount;
+            TO_LAB_record_latency(Held->PktTime);
+        }
+
+        if (Stream != NULL)
+        {
+            if (OsStatus == OS_SUCCESS)
+            {
+                ++Stream->ForwardedCount;
+                Stream->ByteCount += Held->Size;
+            }
+            else
+            {
+                ++Stream->SendErrorCount;
+            }
+        }
+
+        --*TO_LAB_OutputDeferredCount(Chan, Held->Tag);
+        TO_LAB_HoldRelease(Ring);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputMsecToDeadline() -- Time left before batch flush   */
+/*                                                                 */
+/* Returns TO_LAB_TASK_MSEC if nothing is waiting to be sent       */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_OutputMsecToDeadline(const TO_LAB_Channel_t *Chan)
+{
+    const TO_LAB_Batch_t *Batch = &Chan->Batch;
+    OS_time_t             CurrTime;
+    int64                 AgeMsec;
+
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        return TO_LAB_TcpMsecToDeadline(Chan);
+    }
+
+    if (Batch->FrameCount == 0)
+    {
+        return TO_LAB_TASK_MSEC;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+    AgeMsec = OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, Batch->StartTime));
+
+    if (AgeMsec >= TO_LAB_BATCH_MAX_AGE_MSEC)
+    {
+        return 0;
+    }
+
+    return (int32)(TO_LAB_BATCH_MAX_AGE_MSEC - AgeMsec);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputCheckAge() -- Flush the batch once it is too old   */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputCheckAge(TO_LAB_Channel_t *Chan)
+{
+    if (Chan->Transport == TO_LAB_TRANSPORT_TCP)
+    {
+        TO_LAB_TcpService(Chan, false);
+        return;
+    }
+
+    if (Chan->Batch.FrameCount != 0 && TO_LAB_OutputMsecToDeadline(Chan) == 0)
+    {
+        TO_LAB_OutputFlush(Chan);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_OutputDiscard() -- Drop anything batched or held         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_OutputDiscard(TO_LAB_Channel_t *Chan)
+{
+    uint16 i;
+
+    Chan->Batch.FrameCount = 0;
+    Chan->Batch.Size       = 0;
+
+    while (Chan->HoldRing.Count != 0)
+    {
+        TO_LAB_HoldRelease(&Chan->HoldRing);
+    }
+
+    while (Chan->DeferRing.Count != 0)
+    {
+        TO_LAB_HoldRelease(&Chan->DeferRing);
+    }
+
+    Chan->RateLimit.NoStreamDeferred = 0;
+    for (i = 0; i < Chan->RateLimit.NumStreams; i++)
+    {
+        Chan->RateLimit.Stream[i].DeferredCount = 0;
+    }
+}
@@ -0,0 +1,262 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *   TO Lab output datagram framing and transmission
+ *
+ * When TO_LAB_BATCH_ENABLE is set, encoded packets are packed into
+ * datagrams of at most TO_LAB_BATCH_MTU bytes with the following layout
+ * (all multi-byte fields big endian):
+ *
+ *     Offset  Size  Field
+ *     0       1     Magic, 0x54 ('T')
+ *     1       1     Magic, 0x4C ('L')
+ *     2       1     Framing version, currently 1
+ *     3       1     Number of frames that follow (1-255)
+ *     4       2     Length N of the first packet in bytes
+ *     6       N     First packet, exactly as it would be sent unbatched
+ *     ...           Length/packet pairs repeat for each remaining frame
+ *
+ * A packet too large to fit in an otherwise empty batch is sent on its own
+ * as a plain unframed datagram.  The ground side can always tell the two
+ * apart by the first byte: a CCSDS primary header starts with a zero version
+ * field, so it can never begin with the 0x54 magic byte.
+ *
+ * When TO_LAB_VECTOR_SEND_ENABLE is set, the datagrams produced during one
+ * drain cycle are held in a bounded ring and handed to the socket layer
+ * together, each still as a separate datagram, by TO_LAB_OutputSubmitVector().
+ *
+ * Packets held back by a rate limit (see to_lab_ratelimit.h) wait, already
+ * encoded, in a second ring of the same kind and are released in arrival
+ * order by TO_LAB_OutputReleaseDeferred() as the limits allow.
+ *
+ * A datagram whose send fails with a transient error is kept, in a third
+ * ring of the same kind sized by TO_LAB_SEND_RETRY_RING_DEPTH and
+ * TO_LAB_SEND_RETRY_RING_SIZE, and retried by TO_LAB_OutputRetry() with an
+ * exponential backoff; anything sent meanwhile queues behind it.  Only a
+ * fatal error, or a transient one that persists for
+ * TO_LAB_SEND_RETRY_LIMIT attempts, stops output on the channel.  In
+ * TO_LAB_NONBLOCKING_OUTPUT mode a datagram the socket is not ready for
+ * waits in the same ring, without a backoff, and goes out from
+ * TO_LAB_OutputFlushPending() when the socket becomes writable.
+ *
+ * On a channel with compression enabled, each datagram, batched or not, is
+ * compressed as it leaves TO_LAB_OutputSendDatagram(); see
+ * to_lab_compress.h.
+ *
+ * A channel enabled with TO_LAB_TRANSPORT_TCP sends no datagrams:
+ * TO_LAB_OutputWrite() hands each encoded packet to its stream instead;
+ * see to_lab_tcp.h.
+ */
+
+#ifndef TO_LAB_OUTPUT_H
+#define TO_LAB_OUTPUT_H
+
+#include "common_types.h"
+#include "osapi.h"
+#include "cfe_sb.h"
+
+#include "to_lab_msgdefs.h"
+#include "to_lab_platform_cfg.h"
+#include "to_lab_compress.h"
+#include "to_lab_ratelimit.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define TO_LAB_BATCH_MAGIC_0     0x54
+#define TO_LAB_BATCH_MAGIC_1     0x4C
+#define TO_LAB_BATCH_VERSION     1
+#define TO_LAB_BATCH_HDR_SIZE    4
+#define TO_LAB_BATCH_LENGTH_SIZE 2
+#define TO_LAB_BATCH_MAX_FRAMES  255
+
+/**
+ * Send status of a datagram not attempted because the socket was not
+ * writable, in TO_LAB_NONBLOCKING_OUTPUT mode
+ */
+#define TO_LAB_SEND_WOULD_BLOCK OS_ERROR_TIMEOUT
+
+/**
+ * Status of TO_LAB_OutputLimitedWrite() for a packet held back by the
+ * rate limits, and one dropped because the deferral queue was full
+ */
+#define TO_LAB_OUTPUT_DEFERRED      1
+#define TO_LAB_OUTPUT_DEFER_DROPPED 2
+
+/**
+ * Hold ring dimensions for a feature, a placeholder when it is disabled
+ */
+#define TO_LAB_HOLD_DEPTH_IF(Enabled) ((Enabled) ? TO_LAB_HOLD_RING_DEPTH : 1)
+#define TO_LAB_HOLD_SIZE_IF(Enabled)  ((Enabled) ? TO_LAB_HOLD_RING_SIZE : 1)
+
+/**
+ * The retry queue also holds the datagrams of non-blocking output
+ */
+#define TO_LAB_RETRY_QUEUE_ENABLE (TO_LAB_SEND_RETRY_ENABLE || TO_LAB_NONBLOCKING_OUTPUT)
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * State of the datagram currently being batched
+ */
+typedef struct
+{
+    size_t    Size;       /**< Bytes used in Buffer, including the header */
+    uint8     FrameCount; /**< Number of packets in Buffer */
+    OS_time_t StartTime;  /**< Time the first packet was added */
+    uint8     Buffer[TO_LAB_BATCH_MTU];
+} TO_LAB_Batch_t;
+
+/**
+ * One datagram held until its send completes
+ */
+typedef struct
+{
+    size_t             Offset;  /**< Location of the datagram in TO_LAB_HoldRing_t.Data */
+    size_t             Size;    /**< Size of the datagram in bytes */
+    uint16             Tag;     /**< Owner-defined, e.g. the rate limit stream index */
+    uint16             Epoch;   /**< Owner-defined, e.g. the channel's SendEpoch when queued */
+    CFE_SB_MsgId_t     MsgId;   /**< Owner-defined, e.g. the MsgId of a deferred packet */
+    CFE_TIME_SysTime_t PktTime; /**< Owner-defined, e.g. the timestamp of a deferred packet */
+} TO_LAB_HeldBuf_t;
+
+/**
+ * Bounded FIFO of datagrams awaiting a vectored send
+ *
+ * CFE_SB_ReceiveBuffer() releases the previously received SB buffer on the
+ * next receive from the same pipe, and SB provides no way to extend that
+ * lifetime.  Datagrams are therefore held here, in arrival order, and each
+ * one is released only after the socket send for it has completed.
+ *
+ * The entries and data live in storage given to TO_LAB_HoldInit(), sized
+ * for the feature that uses the ring.
+ */
+typedef struct
+{
+    uint32            Head;      /**< Index of the oldest held entry */
+    uint32            Count;     /**< Number of entries held */
+    size_t            DataTail;  /**< Offset in Data where the next datagram goes */
+    uint32            HighWater; /**< Largest value of Count seen */
+    uint32            Depth;     /**< Entries in Entry */
+    size_t            DataSize;  /**< Bytes in Data */
+    TO_LAB_HeldBuf_t *Entry;
+    uint8            *Data;
+} TO_LAB_HoldRing_t;
+
+/**
+ * Stream connection of a channel enabled with TO_LAB_TRANSPORT_TCP
+ *
+ * See to_lab_tcp.h.
+ */
+typedef struct
+{
+    bool      Up;           /**< Connected; TLMsockid is open */
+    bool      Connecting;   /**< A connect on TLMsockid is in progress */
+    bool      Confirmed;    /**< A write has succeeded since the link came up */
+    bool      FailReported; /**< A connect failure or loss was reported since the link was last up */
+    size_t    Head;         /**< Bytes of Buffer already written to the socket */
+    size_t    Size;         /**< Bytes used in Buffer */
+    OS_time_t DueTime;      /**< Time of the next write or connect attempt, or connect deadline */
+    uint8     Buffer[TO_LAB_TCP_ENABLE ? TO_LAB_TCP_BUFFER_SIZE : 1];
+} TO_LAB_TcpLink_t;
+
+/**
+ * Datagrams kept after a transient send error, with their backoff
+ */
+typedef struct
+{
+    TO_LAB_HoldRing_t Ring;        /**< Datagrams awaiting a retry, oldest first */
+    uint16            Attempts;    /**< Consecutive failed retries of the oldest one */
+    uint32            BackoffMsec; /**< Current wait between retries */
+    OS_time_t         NextTime;    /**< Time of the next retry */
+} TO_LAB_SendRetry_t;
+
+/**
+ * One telemetry output channel
+ *
+ * Each channel has its own subscriptions, destination and socket, and is
+ * enabled and disabled independently of the others.
+ */
+typedef struct
+{
+    uint16             ChannelIdx;                /**< Index of this channel in TO_LAB_Global.Channel */
+    CFE_SB_PipeId_t    Tlm_pipe[TO_LAB_NUM_PRIO]; /**< Subscription pipes, by priority class */
+    uint32             BudgetRemaining;           /**< Bytes left in this cycle's budget */
+    uint32             DrainBudget;               /**< Packets this channel may drain per pass */
+    osal_id_t          TLMsockid;                 /**< Output socket, valid while downlink_on */
+    bool               downlink_on;               /**< Output is enabled */
+    bool               suppress_sendto;           /**< Output stopped after a send error */
+    uint16             SendEpoch;                 /**< Changes each time the socket or destination does */
+    uint8              Transport;                 /**< TO_LAB_TRANSPORT_UDP or TO_LAB_TRANSPORT_TCP */
+    char               tlm_dest_IP[17];           /**< Destination address, as given in the enable command */
+    uint16             tlm_dest_port;             /**< Destination UDP or TCP port */
+    OS_SockAddr_t      DestAddr;                  /**< Destination in socket form */
+    bool               Connected;                 /**< TLMsockid is connected to DestAddr */
+    TO_LAB_Batch_t     Batch;
+    TO_LAB_HoldRing_t  HoldRing;
+    TO_LAB_RateLimit_t RateLimit;
+    TO_LAB_HoldRing_t  DeferRing; /**< Encoded packets waiting on a rate limit */
+    TO_LAB_Compress_t  Compress;
+    TO_LAB_SendRetry_t Retry;
+    TO_LAB_TcpLink_t   Tcp;
+
+    /* Storage of the hold rings above */
+    TO_LAB_HeldBuf_t HoldEntry[TO_LAB_HOLD_DEPTH_IF(TO_LAB_VECTOR_SEND_ENABLE)];
+    uint8            HoldData[TO_LAB_HOLD_SIZE_IF(TO_LAB_VECTOR_SEND_ENABLE)];
+    TO_LAB_HeldBuf_t DeferEntry[TO_LAB_HOLD_DEPTH_IF(TO_LAB_RATE_DEFER_ENABLE)];
+    uint8            DeferData[TO_LAB_HOLD_SIZE_IF(TO_LAB_RATE_DEFER_ENABLE)];
+    TO_LAB_HeldBuf_t RetryEntry[TO_LAB_RETRY_QUEUE_ENABLE ? TO_LAB_SEND_RETRY_RING_DEPTH : 1];
+    uint8            RetryData[TO_LAB_RETRY_QUEUE_ENABLE ? TO_LAB_SEND_RETRY_RING_SIZE : 1];
+
+    uint16    PipeHighWater[TO_LAB_NUM_PRIO]; /**< Most packets found queued in one drain pass */
+    uint16    SbPeakDepth[TO_LAB_NUM_PRIO];   /**< Peak pipe depth last reported by SB */
+    uint16    BacklogCycles;                  /**< Consecutive drain passes stopped by the packet cap */
+    bool      BacklogReported;                /**< LastBacklogEvent is valid */
+    OS_time_t LastBacklogEvent;               /**< Time TO_LAB_BACKLOG_ERR_EID was last sent */
+} TO_LAB_Channel_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+int32 TO_LAB_OutputWrite(TO_LAB_Channel_t *Chan, const void *NetBufPtr, size_t NetBufSize);
+int32 TO_LAB_OutputLimitedWrite(TO_LAB_Channel_t *Chan, CFE_SB_MsgId_t MsgId, CFE_TIME_SysTime_t PktTime,
+                                const void *NetBufPtr, size_t NetBufSize);
+void  TO_LAB_OutputReleaseDeferred(TO_LAB_Channel_t *Chan);
+void  TO_LAB_OutputFlush(TO_LAB_Channel_t *Chan);
+void  TO_LAB_OutputCheckAge(TO_LAB_Channel_t *Chan);
+int32 TO_LAB_OutputMsecToDeadline(const TO_LAB_Channel_t *Chan);
+int32 TO_LAB_OutputSendDatagram(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize);
+int32 TO_LAB_OutputSendTo(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize);
+int32 TO_LAB_OutputSocketSend(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize);
+void  TO_LAB_OutputRetry(TO_LAB_Channel_t *Chan);
+void  TO_LAB_OutputFlushPending(TO_LAB_Channel_t *Chan, OS_time_t Deadline);
+void  TO_LAB_OutputRetryDiscard(TO_LAB_Channel_t *Chan);
+void  TO_LAB_OutputSubmitVector(TO_LAB_Channel_t *Chan);
+void  TO_LAB_OutputDiscard(TO_LAB_Channel_t *Chan);
+void  TO_LAB_HoldInit(TO_LAB_HoldRing_t *Ring, TO_LAB_HeldBuf_t *Entry, size_t EntryBytes, uint8 *Data,
+                      size_t DataSize);
+void *TO_LAB_HoldAcquire(TO_LAB_HoldRing_t *Ring, size_t DataSize);
+void  TO_LAB_HoldRelease(TO_LAB_HoldRing_t *Ring);
+
+#endif
@@ -21,6 +21,8 @@
  *  This file contains the source code for the TO lab application
  */
 
+#include <string.h>
+
 #include "cfe_config.h"
 #include "cfe_sb.h"
 #include "cfe_msg.h"
@@ -28,17 +30,27 @@
 #include "to_lab_app.h"
 #include "to_lab_encode.h"
 
+/*
+ * --------------------------------------------
+ * The passthru encoder has no shared state to set up.
+ * --------------------------------------------
+ */
+CFE_Status_t TO_LAB_EncodeInit(void)
+{
+    return CFE_SUCCESS;
+}
+
 /*
  * --------------------------------------------
  * This implements an "encoder" that simply outputs the same pointer that was passed in.
  * This matches the traditional TO behavior where the "C" struct is passed directly to the socket.
  *
  * The only thing this needs to do get the real size of the output datagram, which should be
- * the size stored in the CFE message header.
+ * the size stored in the CFE message header.  The scratch buffer is never used.
  * --------------------------------------------
  */
-CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, const void **DestBufferOut,
-                                        size_t *DestSizeOut)
+CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, void *ScratchBuffer,
+                                        size_t ScratchSize, const void **DestBufferOut, size_t *DestSizeOut)
 {
     CFE_Status_t   ResultStatus;
     CFE_MSG_Size_t SourceBufferSize;
@@ -50,3 +62,39 @@ CFE_Status_t TO_LAB_EncodeOutputMessage(const CFE_SB_Buffer_t *SourceBuffer, con
 
     return ResultStatus;
 }
+
+/*
+ * --------------------------------------------
+ * Same as TO_LAB_EncodeOutputMessage(), but the datagram is copied into a
+ * buffer owned by the caller.
+ * --------------------------------------------
+ */
+CFE_Status_t TO_LAB_EncodeOutputMessageInto(const CFE_SB_Buffer_t *SourceBuffer, void *DestBuffer,
+                                            size_t DestBufferSize, size_t *DestSizeOut)
+{
+    CFE_Status_t   ResultStatus;
+    CFE_MSG_Size_t SourceBufferSize;
+
+    ResultStatus = CFE_MSG_GetSize(&SourceBuffer->Msg, &SourceBufferSize);
+    if (ResultStatus != CFE_SUCCESS)
+    {
+        return ResultStatus;
+    }
+
+    if (SourceBufferSize > DestBufferSize)
+    {
+        return CFE_SB_BUFFER_INVALID;
+    }
+
+    memcpy(DestBuffer, SourceBuffer, SourceBufferSize);
+    *DestSizeOut = SourceBufferSize;
+
+    return CFE_SUCCESS;
+}
+
+/*
+ * --------------------------------------------
+ * The passthru encoder keeps no per-stream state, so there is nothing to forget.
+ * --------------------------------------------
+ */
+void TO_LAB_EncodeInvalidateCache(void) {}
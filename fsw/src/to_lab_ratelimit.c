@@ -0,0 +1,254 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the token bucket rate limiter for the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_ratelimit.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_BucketSet() -- Set the rate of a bucket and fill it      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_BucketSet(TO_LAB_TokenBucket_t *Bucket, uint32 Rate)
+{
+    Bucket->Rate  = Rate;
+    Bucket->Level = (int64)Rate * TO_LAB_RATE_BURST_MSEC;
+    OS_GetLocalTime(&Bucket->LastRefill);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_BucketHasTokens() -- Refill a bucket and check it        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static bool TO_LAB_BucketHasTokens(TO_LAB_TokenBucket_t *Bucket)
+{
+    OS_time_t CurrTime;
+    int64     ElapsedMsec;
+    int64     MaxLevel;
+
+    if (Bucket->Rate == 0)
+    {
+        return true;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+    ElapsedMsec = OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, Bucket->LastRefill));
+
+    /*
+     * Rate tokens/sec over ElapsedMsec is Rate * ElapsedMsec thousandths of
+     * a token, so no fraction is lost however often this is called.
+     */
+    if (ElapsedMsec > 0)
+    {
+        MaxLevel = (int64)Bucket->Rate * TO_LAB_RATE_BURST_MSEC;
+
+        Bucket->Level += (int64)Bucket->Rate * ElapsedMsec;
+        if (Bucket->Level > MaxLevel)
+        {
+            Bucket->Level = MaxLevel;
+        }
+
+        Bucket->LastRefill = CurrTime;
+    }
+    else if (ElapsedMsec < 0)
+    {
+        /* Local time stepped backwards, restart the refill from now */
+        Bucket->LastRefill = CurrTime;
+    }
+
+    return (Bucket->Level > 0);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_BucketCharge() -- Take tokens from a bucket              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_BucketCharge(TO_LAB_TokenBucket_t *Bucket, size_t Tokens)
+{
+    if (Bucket->Rate != 0)
+    {
+        Bucket->Level -= (int64)Tokens * 1000;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitInit() -- Set a channel's limits from its       */
+/*                           section of the subscription table     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_RateLimitInit(TO_LAB_RateLimit_t *Limit, const TO_LAB_Sub_t *Subs)
+{
+    uint16 i;
+
+    memset(Limit, 0, sizeof(*Limit));
+
+    TO_LAB_RateLimitSetChannel(Limit, TO_LAB_RATE_BYTES_PER_SEC, TO_LAB_RATE_PKTS_PER_SEC);
+
+    for (i = 0; i < TO_LAB_MAX_SUBSCRIPTIONS; i++)
+    {
+        if (CFE_SB_MsgId_Equal(Subs[i].Stream, CFE_SB_MSGID_RESERVED))
+        {
+            break;
+        }
+
+        if (Subs[i].BytesPerSec != 0 || Subs[i].PktsPerSec != 0)
+        {
+            TO_LAB_RateLimitSetStream(Limit, Subs[i].Stream, Subs[i].BytesPerSec, Subs[i].PktsPerSec);
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitSetChannel() -- Set the limits of a channel     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_RateLimitSetChannel(TO_LAB_RateLimit_t *Limit, uint32 BytesPerSec, uint32 PktsPerSec)
+{
+    TO_LAB_BucketSet(&Limit->Bytes, BytesPerSec);
+    TO_LAB_BucketSet(&Limit->Pkts, PktsPerSec);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitSetStream() -- Set the limits of one stream     */
+/*                                                                 */
+/* Returns CFE_STATUS_RANGE_ERROR if every stream entry is in use  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_RateLimitSetStream(TO_LAB_RateLimit_t *Limit, CFE_SB_MsgId_t MsgId, uint32 BytesPerSec,
+                                uint32 PktsPerSec)
+{
+    TO_LAB_StreamLimit_t *Stream;
+    uint16                StreamIdx;
+
+    StreamIdx = TO_LAB_RateLimitFindStream(Limit, MsgId);
+    if (StreamIdx == TO_LAB_RATE_NO_STREAM)
+    {
+        if (Limit->NumStreams >= TO_LAB_MAX_SUBSCRIPTIONS)
+        {
+            return CFE_STATUS_RANGE_ERROR;
+        }
+
+        /* Entries are never removed: deferred packets refer to them by index */
+        StreamIdx = Limit->NumStreams;
+        ++Limit->NumStreams;
+
+        Limit->Stream[StreamIdx].MsgId         = MsgId;
+        Limit->Stream[StreamIdx].DeferredCount = 0;
+    }
+
+    Stream = &Limit->Stream[StreamIdx];
+    TO_LAB_BucketSet(&Stream->Bytes, BytesPerSec);
+    TO_LAB_BucketSet(&Stream->Pkts, PktsPerSec);
+
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitFindStream() -- Look up a stream's limits       */
+/*                                                                 */
+/* Returns TO_LAB_RATE_NO_STREAM if the stream has none            */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint16 TO_LAB_RateLimitFindStream(const TO_LAB_RateLimit_t *Limit, CFE_SB_MsgId_t MsgId)
+{
+    uint16 i;
+
+    for (i = 0; i < Limit->NumStreams; i++)
+    {
+        if (CFE_SB_MsgId_Equal(Limit->Stream[i].MsgId, MsgId))
+        {
+            return i;
+        }
+    }
+
+    return TO_LAB_RATE_NO_STREAM;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitChannelOpen() -- Check the channel-wide limits  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_RateLimitChannelOpen(TO_LAB_RateLimit_t *Limit)
+{
+    bool BytesOpen;
+    bool PktsOpen;
+
+    /* Evaluate both so each bucket is refilled */
+    BytesOpen = TO_LAB_BucketHasTokens(&Limit->Bytes);
+    PktsOpen  = TO_LAB_BucketHasTokens(&Limit->Pkts);
+
+    return (BytesOpen && PktsOpen);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitAdmit() -- Check every limit on a packet        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_RateLimitAdmit(TO_LAB_RateLimit_t *Limit, uint16 StreamIdx)
+{
+    TO_LAB_StreamLimit_t *Stream;
+    bool                  BytesOpen;
+    bool                  PktsOpen;
+
+    if (!TO_LAB_RateLimitChannelOpen(Limit))
+    {
+        return false;
+    }
+
+    if (StreamIdx == TO_LAB_RATE_NO_STREAM)
+    {
+        return true;
+    }
+
+    Stream    = &Limit->Stream[StreamIdx];
+    BytesOpen = TO_LAB_BucketHasTokens(&Stream->Bytes);
+    PktsOpen  = TO_LAB_BucketHasTokens(&Stream->Pkts);
+
+    return (BytesOpen && PktsOpen);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_RateLimitCharge() -- Account a packet that was sent      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_RateLimitCharge(TO_LAB_RateLimit_t *Limit, uint16 StreamIdx, size_t Size)
+{
+    TO_LAB_BucketCharge(&Limit->Bytes, Size);
+    TO_LAB_BucketCharge(&Limit->Pkts, 1);
+
+    if (StreamIdx != TO_LAB_RATE_NO_STREAM)
+    {
+        TO_LAB_BucketCharge(&Limit->Stream[StreamIdx].Bytes, Size);
+        TO_LAB_BucketCharge(&Limit->Stream[StreamIdx].Pkts, 1);
+    }
+}
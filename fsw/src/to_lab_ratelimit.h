@@ -0,0 +1,101 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Token bucket rate limits for the TO lab output path
+ *
+ * Each channel has one pair of buckets (bytes and packets per second) that
+ * covers everything it sends, plus an optional pair per MsgId.  A bucket
+ * refills continuously at its rate up to TO_LAB_RATE_BURST_MSEC worth of
+ * tokens.  A packet may be sent whenever every bucket that applies to it
+ * still has tokens left; sending it may take a bucket into debt, so a
+ * packet larger than the burst allowance is delayed, never blocked.
+ */
+
+#ifndef TO_LAB_RATELIMIT_H
+#define TO_LAB_RATELIMIT_H
+
+#include "common_types.h"
+#include "osapi.h"
+#include "cfe_sb.h"
+
+#include "to_lab_platform_cfg.h"
+#include "to_lab_tbldefs.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/**
+ * Stream index of a packet with no per-stream limit
+ */
+#define TO_LAB_RATE_NO_STREAM 0xFFFF
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * One token bucket
+ */
+typedef struct
+{
+    uint32    Rate;       /**< Tokens added per second, 0 for no limit */
+    int64     Level;      /**< Tokens available, in thousandths; negative while in debt */
+    OS_time_t LastRefill; /**< Time Level was last brought up to date */
+} TO_LAB_TokenBucket_t;
+
+/**
+ * Limits applied to one stream
+ */
+typedef struct
+{
+    CFE_SB_MsgId_t       MsgId;
+    TO_LAB_TokenBucket_t Bytes;
+    TO_LAB_TokenBucket_t Pkts;
+    uint16               DeferredCount; /**< Packets of this stream in the deferral queue */
+} TO_LAB_StreamLimit_t;
+
+/**
+ * All limits applied to one channel
+ */
+typedef struct
+{
+    TO_LAB_TokenBucket_t Bytes;
+    TO_LAB_TokenBucket_t Pkts;
+    uint16               NoStreamDeferred; /**< Packets without stream limits in the deferral queue */
+    uint16               NumStreams;
+    TO_LAB_StreamLimit_t Stream[TO_LAB_MAX_SUBSCRIPTIONS];
+} TO_LAB_RateLimit_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+void   TO_LAB_RateLimitInit(TO_LAB_RateLimit_t *Limit, const TO_LAB_Sub_t *Subs);
+void   TO_LAB_RateLimitSetChannel(TO_LAB_RateLimit_t *Limit, uint32 BytesPerSec, uint32 PktsPerSec);
+int32  TO_LAB_RateLimitSetStream(TO_LAB_RateLimit_t *Limit, CFE_SB_MsgId_t MsgId, uint32 BytesPerSec,
+                                 uint32 PktsPerSec);
+uint16 TO_LAB_RateLimitFindStream(const TO_LAB_RateLimit_t *Limit, CFE_SB_MsgId_t MsgId);
+bool   TO_LAB_RateLimitChannelOpen(TO_LAB_RateLimit_t *Limit);
+bool   TO_LAB_RateLimitAdmit(TO_LAB_RateLimit_t *Limit, uint16 StreamIdx);
+void   TO_LAB_RateLimitCharge(TO_LAB_RateLimit_t *Limit, uint16 StreamIdx, size_t Size);
+
+#endif
@@ -0,0 +1,381 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the sender task of the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_sender.h"
+#include "to_lab_eventids.h"
+#include "to_lab_perfids.h"
+
+/*
+ * OSAL has no atomic operations, so the ring indices use the GCC/Clang
+ * builtins, which every supported cFS toolchain provides.
+ */
+static inline uint32 TO_LAB_SenderLoad(const uint32 *Index)
+{
+    return __atomic_load_n(Index, __ATOMIC_ACQUIRE);
+}
+
+static inline void TO_LAB_SenderStore(uint32 *Index, uint32 Value)
+{
+    __atomic_store_n(Index, Value, __ATOMIC_RELEASE);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderInit() -- Start the sender task                    */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_SenderInit(void)
+{
+    TO_LAB_Sender_t *Sender = &TO_LAB_Global.Sender;
+    int32            status;
+
+    status = OS_CountSemCreate(&Sender->ReadySem, "TO_LAB_SEND_SEM", 0, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_SENDER_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't create sender semaphore status %i", __LINE__, (int)status);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    status = OS_MutSemCreate(&Sender->Mutex, "TO_LAB_SEND_MUT", 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_SENDER_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't create sender mutex status %i", __LINE__, (int)status);
+        OS_CountSemDelete(Sender->ReadySem);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    status = CFE_ES_CreateChildTask(&Sender->TaskId, "TO_LAB_SENDER", TO_LAB_SenderTask, NULL,
+                                    TO_LAB_SENDER_STACK_SIZE, TO_LAB_SENDER_PRIORITY, 0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(TO_LAB_SENDER_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO Can't create sender task status %i", __LINE__, (int)status);
+        OS_MutSemDelete(Sender->Mutex);
+        OS_CountSemDelete(Sender->ReadySem);
+        return status;
+    }
+
+    Sender->Running = true;
+
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderRetryPending() -- Check for datagrams kept after a */
+/*                                transient error                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static bool TO_LAB_SenderRetryPending(void)
+{
+    uint16 i;
+
+    for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+    {
+        if (TO_LAB_Global.Channel[i].Retry.Ring.Count != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderTask() -- Send queued datagrams                    */
+/*                                                                 */
+/* While any channel has datagrams waiting for a retry, the task   */
+/* also wakes every TO_LAB_SEND_RETRY_MIN_MSEC to retry them.      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SenderTask(void)
+{
+    TO_LAB_Sender_t        *Sender = &TO_LAB_Global.Sender;
+    TO_LAB_SendRing_t      *Ring   = &Sender->Ring;
+    const TO_LAB_HeldBuf_t *Held;
+    TO_LAB_Channel_t       *Chan;
+    uint32                  Head;
+    int32                   status;
+    uint16                  i;
+
+    while (true)
+    {
+        if (TO_LAB_SenderRetryPending())
+        {
+            status = OS_CountSemTimedWait(Sender->ReadySem, TO_LAB_SEND_RETRY_MIN_MSEC);
+        }
+        else
+        {
+            status = OS_CountSemTake(Sender->ReadySem);
+        }
+
+        if (status != OS_SUCCESS && status != OS_SEM_TIMEOUT)
+        {
+            break;
+        }
+
+        OS_MutSemTake(Sender->Mutex);
+        CFE_ES_PerfLogEntry(TO_LAB_SENDER_PERF_ID);
+
+        /* Datagrams kept after an error go ahead of anything queued since */
+        for (i = 0; i < TO_LAB_MAX_CHANNELS; i++)
+        {
+            TO_LAB_OutputRetry(&TO_LAB_Global.Channel[i]);
+        }
+
+        Head = Ring->Head;
+        if (status == OS_SUCCESS && Head != TO_LAB_SenderLoad(&Ring->Tail))
+        {
+            Held = &Ring->Entry[Head % TO_LAB_SEND_RING_ENTRIES];
+            Chan = &TO_LAB_Global.Channel[Held->Tag];
+
+            if (Held->Epoch != Chan->SendEpoch || !Chan->downlink_on)
+            {
+                /* Queued for a socket or destination that has since changed; the main task adds this to HK */
+                ++Sender->StaleDropCount;
+            }
+            else if (!Chan->suppress_sendto)
+            {
+                TO_LAB_OutputSendTo(Chan, &Ring->Data[Held->Offset], Held->Size);
+            }
+
+            /* The entry's data may be reused as soon as Head moves past it */
+            TO_LAB_SenderStore(&Ring->Head, Head + 1);
+        }
+
+        CFE_ES_PerfLogExit(TO_LAB_SENDER_PERF_ID);
+        OS_MutSemGive(Sender->Mutex);
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderAcquire() -- Find room for a datagram in the ring  */
+/*                                                                 */
+/* Returns NULL if the ring cannot take DataSize more bytes now    */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void *TO_LAB_SenderAcquire(TO_LAB_SendRing_t *Ring, size_t DataSize, size_t *OffsetPtr)
+{
+    uint32 Head;
+    uint32 Count;
+    size_t DataHead;
+    size_t Offset;
+
+    Head  = TO_LAB_SenderLoad(&Ring->Head);
+    Count = Ring->Tail - Head;
+
+    if (Count >= TO_LAB_SEND_RING_ENTRIES)
+    {
+        return NULL;
+    }
+
+    if (Count == 0)
+    {
+        /* The sender task is not reading any data, start again at the front */
+        Offset = 0;
+    }
+    else
+    {
+        DataHead = Ring->Entry[Head % TO_LAB_SEND_RING_ENTRIES].Offset;
+
+        if (Ring->DataTail > DataHead)
+        {
+            /* Free space is after the tail and, by wrapping, before the head */
+            if ((sizeof(Ring->Data) - Ring->DataTail) >= DataSize)
+            {
+                Offset = Ring->DataTail;
+            }
+            else if (DataHead >= DataSize)
+            {
+                Offset = 0;
+            }
+            else
+            {
+                return NULL;
+            }
+        }
+        else if ((DataHead - Ring->DataTail) >= DataSize)
+        {
+            Offset = Ring->DataTail;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+
+    *OffsetPtr = Offset;
+    return &Ring->Data[Offset];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderEnqueue() -- Queue a datagram for the sender task  */
+/*                                                                 */
+/* Waits up to TO_LAB_SENDER_STALL_MSEC for room, then drops the   */
+/* datagram.  Returns OS_QUEUE_FULL if it was dropped.             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_SenderEnqueue(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    TO_LAB_Sender_t   *Sender = &TO_LAB_Global.Sender;
+    TO_LAB_SendRing_t *Ring   = &Sender->Ring;
+    TO_LAB_HeldBuf_t  *Held;
+    void              *SlotPtr;
+    size_t             Offset;
+    uint32             WaitMsec;
+    uint32             Count;
+
+    SlotPtr = NULL;
+    if (DataSize != 0 && DataSize <= sizeof(Ring->Data))
+    {
+        for (WaitMsec = 0;; WaitMsec++)
+        {
+            SlotPtr = TO_LAB_SenderAcquire(Ring, DataSize, &Offset);
+            if (SlotPtr != NULL || WaitMsec >= TO_LAB_SENDER_STALL_MSEC)
+            {
+                break;
+            }
+
+            if (WaitMsec == 0)
+            {
+                ++TO_LAB_Global.HkTlm.Payload.SendStallCount;
+            }
+
+            OS_TaskDelay(1);
+        }
+    }
+
+    if (SlotPtr == NULL)
+    {
+        ++TO_LAB_Global.HkTlm.Payload.SendRingDropCount;
+        return OS_QUEUE_FULL;
+    }
+
+    memcpy(SlotPtr, DataPtr, DataSize);
+
+    Held         = &Ring->Entry[Ring->Tail % TO_LAB_SEND_RING_ENTRIES];
+    Held->Offset = Offset;
+    Held->Size   = DataSize;
+    Held->Tag    = Chan->ChannelIdx;
+    Held->Epoch  = Chan->SendEpoch;
+
+    Ring->DataTail = Offset + DataSize;
+    TO_LAB_SenderStore(&Ring->Tail, Ring->Tail + 1);
+
+    OS_CountSemGive(Sender->ReadySem);
+
+    Count = TO_LAB_SenderQueued();
+    if (Count > Sender->HighWater)
+    {
+        Sender->HighWater = Count;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderQuiesce() -- Stop the sender task using a channel  */
+/*                                                                 */
+/* Used before a channel's socket or destination changes.  Waits   */
+/* up to TO_LAB_SENDER_STALL_MSEC for queued datagrams to go out,  */
+/* then holds the sender task off until TO_LAB_SenderUnlock().     */
+/* Datagrams the channel still has queued are dropped.             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SenderQuiesce(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_Sender_t *Sender = &TO_LAB_Global.Sender;
+    uint32           WaitMsec;
+    uint16           Queued;
+
+    if (!Sender->Running)
+    {
+        return;
+    }
+
+    for (WaitMsec = 0; WaitMsec < TO_LAB_SENDER_STALL_MSEC && TO_LAB_SenderQueued() != 0; WaitMsec++)
+    {
+        OS_TaskDelay(1);
+    }
+
+    TO_LAB_SenderLock();
+
+    Queued = TO_LAB_SenderQueued();
+    if (Queued != 0)
+    {
+        CFE_EVS_SendEvent(TO_LAB_SENDER_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO sender task still had %u datagrams queued, those for channel %u are dropped",
+                          __LINE__, (unsigned int)Queued, (unsigned int)Chan->ChannelIdx);
+    }
+
+    ++Chan->SendEpoch;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderLock() -- Hold the sender task off                 */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SenderLock(void)
+{
+    if (TO_LAB_Global.Sender.Running)
+    {
+        OS_MutSemTake(TO_LAB_Global.Sender.Mutex);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderUnlock() -- Let the sender task run again          */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SenderUnlock(void)
+{
+    if (TO_LAB_Global.Sender.Running)
+    {
+        OS_MutSemGive(TO_LAB_Global.Sender.Mutex);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SenderQueued() -- Number of datagrams waiting to be sent */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+uint16 TO_LAB_SenderQueued(void)
+{
+    TO_LAB_SendRing_t *Ring = &TO_LAB_Global.Sender.Ring;
+
+    return (uint16)(Ring->Tail - TO_LAB_SenderLoad(&Ring->Head));
+}
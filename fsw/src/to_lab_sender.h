@@ -0,0 +1,111 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Sender task of the TO lab application
+ *
+ * When TO_LAB_SENDER_TASK_ENABLE is set, the main task no longer calls the
+ * socket layer itself.  Each finished datagram is copied into a
+ * single-producer/single-consumer ring and a child task sends it, so a slow
+ * or blocking send does not hold up draining the telemetry pipes.
+ *
+ * The main task is the only writer of Tail and the sender task the only
+ * writer of Head.  Each index is published with a release store and read
+ * with an acquire load, so neither side takes a lock; a counting semaphore
+ * only wakes the sender task when entries are waiting.  Datagrams keep the
+ * order in which they were produced, across all channels.
+ *
+ * The sender task holds Mutex while it sends, and retries datagrams kept
+ * after a transient error on its own timer.  Before changing a channel's
+ * socket or destination the main task calls TO_LAB_SenderQuiesce(), which
+ * takes Mutex, and TO_LAB_SenderUnlock() afterwards.  Datagrams still
+ * queued for the channel from before the change are dropped, never sent on
+ * the new socket.
+ *
+ * The send counters and histograms the sender task updates are only read
+ * or reset by the main task under TO_LAB_SenderLock().  The one counter
+ * both tasks would increment, SendRingDropCount, has a sender task copy
+ * in StaleDropCount that the main task folds in when it sends HK.
+ */
+
+#ifndef TO_LAB_SENDER_H
+#define TO_LAB_SENDER_H
+
+#include "common_types.h"
+#include "osapi.h"
+#include "cfe_es.h"
+
+#include "to_lab_platform_cfg.h"
+#include "to_lab_output.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* The ring is only allocated when the sender task is enabled */
+#define TO_LAB_SEND_RING_ENTRIES (TO_LAB_SENDER_TASK_ENABLE ? TO_LAB_SEND_RING_DEPTH : 1)
+#define TO_LAB_SEND_RING_BYTES   (TO_LAB_SENDER_TASK_ENABLE ? TO_LAB_SEND_RING_SIZE : 1)
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * Datagrams waiting for the sender task
+ *
+ * Data is laid out as in TO_LAB_HoldRing_t; an entry's Tag is the index of
+ * the channel it is sent on.
+ */
+typedef struct
+{
+    uint32           Head;     /**< Entries sent; written only by the sender task */
+    uint32           Tail;     /**< Entries queued; written only by the main task */
+    size_t           DataTail; /**< Offset just past the newest entry's data; main task only */
+    TO_LAB_HeldBuf_t Entry[TO_LAB_SEND_RING_ENTRIES];
+    uint8            Data[TO_LAB_SEND_RING_BYTES];
+} TO_LAB_SendRing_t;
+
+/**
+ * Sender task state
+ */
+typedef struct
+{
+    TO_LAB_SendRing_t Ring;
+    osal_id_t         ReadySem;       /**< Counts entries queued for the sender task */
+    osal_id_t         Mutex;          /**< Held while sending, or while a channel is reconfigured */
+    CFE_ES_TaskId_t   TaskId;
+    bool              Running;        /**< Sender task was created */
+    uint16            HighWater;      /**< Most entries queued at once since reset */
+    uint32            StaleDropCount; /**< Entries the sender task dropped, not yet in SendRingDropCount */
+} TO_LAB_Sender_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+int32  TO_LAB_SenderInit(void);
+void   TO_LAB_SenderTask(void);
+int32  TO_LAB_SenderEnqueue(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize);
+void   TO_LAB_SenderQuiesce(TO_LAB_Channel_t *Chan);
+void   TO_LAB_SenderLock(void);
+void   TO_LAB_SenderUnlock(void);
+uint16 TO_LAB_SenderQueued(void);
+
+#endif
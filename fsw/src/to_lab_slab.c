@@ -0,0 +1,135 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the packet buffer slab pool of the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_slab.h"
+
+/*
+ * The classes must be ordered by size, and the largest must hold any
+ * message SB can deliver, or some packets could never get a buffer.
+ */
+CompileTimeAssert(TO_LAB_SLAB_SMALL_SIZE <= TO_LAB_SLAB_MEDIUM_SIZE, TO_LAB_SlabClassOrder1);
+CompileTimeAssert(TO_LAB_SLAB_MEDIUM_SIZE <= TO_LAB_SLAB_LARGE_SIZE, TO_LAB_SlabClassOrder2);
+CompileTimeAssert(TO_LAB_SLAB_LARGE_SIZE >= CFE_MISSION_SB_MAX_SB_MSG_SIZE, TO_LAB_SlabLargeTooSmall);
+CompileTimeAssert(TO_LAB_SLAB_TOTAL_COUNT <= 0xFFFF, TO_LAB_SlabTooManyBuffers);
+
+/*
+ * --------------------------------------------
+ * Set up one class with every buffer free
+ * --------------------------------------------
+ */
+static void TO_LAB_SlabInitClass(TO_LAB_SlabClass_t *Class, void *Base, size_t BufSize, uint16 NumBufs)
+{
+    uint16 i;
+
+    Class->Base    = Base;
+    Class->BufSize = BufSize;
+    Class->NumBufs = NumBufs;
+    Class->NumFree = NumBufs;
+
+    /* Hand out the lowest buffers first */
+    for (i = 0; i < NumBufs; i++)
+    {
+        Class->FreeList[i] = NumBufs - 1 - i;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SlabInit() -- Mark every buffer free                     */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SlabInit(void)
+{
+    TO_LAB_Slab_t *Slab = &TO_LAB_Global.Slab;
+
+    TO_LAB_SlabInitClass(&Slab->Class[0], Slab->Small, sizeof(Slab->Small[0]), TO_LAB_SLAB_SMALL_BUFS);
+    TO_LAB_SlabInitClass(&Slab->Class[1], Slab->Medium, sizeof(Slab->Medium[0]), TO_LAB_SLAB_MEDIUM_BUFS);
+    TO_LAB_SlabInitClass(&Slab->Class[2], Slab->Large, sizeof(Slab->Large[0]), TO_LAB_SLAB_LARGE_BUFS);
+
+    Slab->InUse = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SlabAlloc() -- Get a buffer of at least Size bytes       */
+/*                                                                 */
+/* Returns NULL if no class with large enough buffers has one      */
+/* free.                                                           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void *TO_LAB_SlabAlloc(size_t Size)
+{
+    TO_LAB_Slab_t      *Slab = &TO_LAB_Global.Slab;
+    TO_LAB_SlabClass_t *Class;
+    uint16              i;
+
+    for (i = 0; i < TO_LAB_SLAB_NUM_CLASSES; i++)
+    {
+        Class = &Slab->Class[i];
+
+        if (Class->BufSize >= Size && Class->NumFree > 0)
+        {
+            --Class->NumFree;
+
+            ++Slab->InUse;
+            if (Slab->InUse > Slab->HighWater)
+            {
+                Slab->HighWater = Slab->InUse;
+            }
+
+            return Class->Base + (Class->FreeList[Class->NumFree] * Class->BufSize);
+        }
+    }
+
+    ++Slab->AllocFailCount;
+    return NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_SlabFree() -- Return a buffer to its class               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_SlabFree(void *BufPtr)
+{
+    TO_LAB_Slab_t      *Slab = &TO_LAB_Global.Slab;
+    TO_LAB_SlabClass_t *Class;
+    uint8              *Buf = BufPtr;
+    uint16              i;
+
+    for (i = 0; i < TO_LAB_SLAB_NUM_CLASSES; i++)
+    {
+        Class = &Slab->Class[i];
+
+        if (Buf >= Class->Base && Buf < (Class->Base + (Class->NumBufs * Class->BufSize)))
+        {
+            Class->FreeList[Class->NumFree] = (Buf - Class->Base) / Class->BufSize;
+            ++Class->NumFree;
+            --Slab->InUse;
+            return;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Slab pool of packet buffers for the TO lab application
+ *
+ * Packet buffers that must outlive the forwarding of a single packet come
+ * from here rather than from the heap.  The pool has three classes of fixed
+ * size buffers, dimensioned in the platform configuration; a request is
+ * served from the smallest class with buffers large enough and one free.
+ * Allocating and freeing pop and push a per-class free list, so both take
+ * constant time.
+ *
+ * Every buffer is aligned for use as a CFE_SB_Buffer_t.  The pool is used by
+ * the main task only and does no locking.
+ */
+
+#ifndef TO_LAB_SLAB_H
+#define TO_LAB_SLAB_H
+
+#include "common_types.h"
+#include "cfe_sb.h"
+
+#include "to_lab_platform_cfg.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define TO_LAB_SLAB_NUM_CLASSES 3
+
+/* Only the encode workers use the pool; without them it is a placeholder */
+#define TO_LAB_SLAB_IF_USED(Value) ((TO_LAB_ENCODE_WORKERS > 0) ? (Value) : 1)
+
+#define TO_LAB_SLAB_SMALL_BUFS  TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_SMALL_COUNT)
+#define TO_LAB_SLAB_MEDIUM_BUFS TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_MEDIUM_COUNT)
+#define TO_LAB_SLAB_LARGE_BUFS  TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_LARGE_COUNT)
+#define TO_LAB_SLAB_TOTAL_COUNT (TO_LAB_SLAB_SMALL_BUFS + TO_LAB_SLAB_MEDIUM_BUFS + TO_LAB_SLAB_LARGE_BUFS)
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * One buffer of each class; the union makes the array stride a multiple of
+ * the SB buffer alignment.
+ */
+typedef union
+{
+    CFE_SB_Buffer_t Align;
+    uint8           Bytes[TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_SMALL_SIZE)];
+} TO_LAB_SlabSmallBuf_t;
+
+typedef union
+{
+    CFE_SB_Buffer_t Align;
+    uint8           Bytes[TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_MEDIUM_SIZE)];
+} TO_LAB_SlabMediumBuf_t;
+
+typedef union
+{
+    CFE_SB_Buffer_t Align;
+    uint8           Bytes[TO_LAB_SLAB_IF_USED(TO_LAB_SLAB_LARGE_SIZE)];
+} TO_LAB_SlabLargeBuf_t;
+
+/**
+ * Free list of one buffer class
+ */
+typedef struct
+{
+    uint8 *Base;                              /**< First buffer of the class */
+    size_t BufSize;                           /**< Stride, and usable size, of each buffer */
+    uint16 NumBufs;                           /**< Buffers in the class */
+    uint16 NumFree;                           /**< Valid entries in FreeList */
+    uint16 FreeList[TO_LAB_SLAB_TOTAL_COUNT]; /**< Indices of free buffers */
+} TO_LAB_SlabClass_t;
+
+/**
+ * The slab pool
+ */
+typedef struct
+{
+    TO_LAB_SlabClass_t Class[TO_LAB_SLAB_NUM_CLASSES]; /**< Ordered smallest first */
+
+    uint16 InUse;          /**< Buffers allocated, all classes */
+    uint16 HighWater;      /**< Most buffers allocated at once since reset */
+    uint32 AllocFailCount; /**< Requests no free buffer could satisfy */
+
+    TO_LAB_SlabSmallBuf_t  Small[TO_LAB_SLAB_SMALL_BUFS];
+    TO_LAB_SlabMediumBuf_t Medium[TO_LAB_SLAB_MEDIUM_BUFS];
+    TO_LAB_SlabLargeBuf_t  Large[TO_LAB_SLAB_LARGE_BUFS];
+} TO_LAB_Slab_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+void  TO_LAB_SlabInit(void);
+void *TO_LAB_SlabAlloc(size_t Size);
+void  TO_LAB_SlabFree(void *BufPtr);
+
+#endif
@@ -0,0 +1,266 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the MsgId-indexed stream table of the TO lab application
+ */
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_streams.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamHash() -- Home slot of a MsgId in the index        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static inline uint32 TO_LAB_StreamHash(CFE_SB_MsgId_t MsgId)
+{
+    uint32 Value = CFE_SB_MsgIdToValue(MsgId);
+
+    /* MsgIds are mostly small and dense; mix the bits so neighbours spread */
+    Value *= 0x9E3779B1;
+
+    return (Value >> 16) & (TO_LAB_STREAM_HASH_SIZE - 1);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamLookup() -- Find a stream by MsgId                 */
+/*                                                                 */
+/* Returns NULL if the stream is not known                         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+TO_LAB_Stream_t *TO_LAB_StreamLookup(CFE_SB_MsgId_t MsgId)
+{
+    TO_LAB_StreamTable_t *Table = &TO_LAB_Global.Streams;
+    uint32                Slot;
+    uint32                Probe;
+    uint16                Entry;
+
+    Slot = TO_LAB_StreamHash(MsgId);
+
+    for (Probe = 0; Probe < TO_LAB_STREAM_HASH_SIZE; Probe++)
+    {
+        Entry = Table->Index[Slot];
+        if (Entry == 0)
+        {
+            break;
+        }
+
+        if (CFE_SB_MsgId_Equal(Table->Stream[Entry - 1].MsgId, MsgId))
+        {
+            return &Table->Stream[Entry - 1];
+        }
+
+        Slot = (Slot + 1) & (TO_LAB_STREAM_HASH_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamRegister() -- Find or add a stream                 */
+/*                                                                 */
+/* Returns NULL if the table is full                               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+TO_LAB_Stream_t *TO_LAB_StreamRegister(CFE_SB_MsgId_t MsgId)
+{
+    TO_LAB_StreamTable_t *Table = &TO_LAB_Global.Streams;
+    TO_LAB_Stream_t      *Stream;
+    uint32                Slot;
+
+    Stream = TO_LAB_StreamLookup(MsgId);
+    if (Stream != NULL)
+    {
+        return Stream;
+    }
+
+    if (Table->NumStreams >= TO_LAB_MAX_STREAMS)
+    {
+        return NULL;
+    }
+
+    /* The index is larger than the table, so a free slot always exists */
+    Slot = TO_LAB_StreamHash(MsgId);
+    while (Table->Index[Slot] != 0)
+    {
+        Slot = (Slot + 1) & (TO_LAB_STREAM_HASH_SIZE - 1);
+    }
+
+    Stream = &Table->Stream[Table->NumStreams];
+    memset(Stream, 0, sizeof(*Stream));
+    Stream->MsgId = MsgId;
+
+    ++Table->NumStreams;
+    Table->Index[Slot] = Table->NumStreams;
+
+    return Stream;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamSetFilter() -- Set the decimation of a stream on   */
+/*                             one channel                         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_StreamSetFilter(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, uint16 Decimation, uint16 MinIntervalMsec)
+{
+    TO_LAB_StreamFilter_t *Filter = &Stream->Filter[ChannelIdx];
+
+    Filter->Decimation      = Decimation;
+    Filter->MinIntervalMsec = MinIntervalMsec;
+    Filter->SkipCount       = 0;
+    Filter->HasSent         = false;
+    Filter->HasHash         = false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamFilterPass() -- Apply a stream's decimation        */
+/*                                                                 */
+/* Returns true if the packet should be sent.  The first packet of */
+/* a stream is always sent; after that, a packet is sent only once */
+/* Decimation - 1 have been dropped and MinIntervalMsec has passed */
+/* since the last one sent.                                        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_StreamFilterPass(TO_LAB_Stream_t *Stream, uint16 ChannelIdx)
+{
+    TO_LAB_StreamFilter_t *Filter = &Stream->Filter[ChannelIdx];
+    OS_time_t              CurrTime;
+    bool                   Pass;
+
+    if (Filter->Decimation <= 1 && Filter->MinIntervalMsec == 0)
+    {
+        return true;
+    }
+
+    Pass = !Filter->HasSent || (Filter->SkipCount + 1) >= Filter->Decimation;
+
+    if (Pass && Filter->MinIntervalMsec != 0)
+    {
+        OS_GetLocalTime(&CurrTime);
+
+        if (Filter->HasSent &&
+            OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, Filter->LastSendTime)) < Filter->MinIntervalMsec)
+        {
+            Pass = false;
+        }
+        else
+        {
+            Filter->LastSendTime = CurrTime;
+        }
+    }
+
+    if (Pass)
+    {
+        Filter->HasSent   = true;
+        Filter->SkipCount = 0;
+    }
+    else
+    {
+        ++Filter->SkipCount;
+        ++Stream->DecimatedCount[ChannelIdx];
+    }
+
+    return Pass;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamChangedPass() -- Drop unchanged packets            */
+/*                                                                 */
+/* Returns true if the packet should be sent: the stream does not  */
+/* use TO_LAB_SUB_OPT_SKIP_SAME, its payload differs from the last */
+/* one sent, or TO_LAB_SKIP_SAME_HEARTBEAT_MSEC has passed since   */
+/* then.  Headers are left out of the comparison, as their         */
+/* sequence count and time change with every packet.               */
+/*                                                                 */
+/* The payload hash is returned in HashPtr; it only becomes the    */
+/* one compared against once TO_LAB_StreamChangedCommit() is       */
+/* called for a packet actually accepted for output.               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool TO_LAB_StreamChangedPass(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, const CFE_SB_Buffer_t *SBBufPtr,
+                              uint32 *HashPtr)
+{
+    TO_LAB_StreamFilter_t *Filter = &Stream->Filter[ChannelIdx];
+    const uint8           *Payload;
+    CFE_MSG_Size_t         MsgSize;
+    OS_time_t              CurrTime;
+    uint32                 Hash;
+    size_t                 i;
+
+    *HashPtr = 0;
+
+    if (!(Stream->Options[ChannelIdx] & TO_LAB_SUB_OPT_SKIP_SAME) ||
+        CFE_MSG_GetSize(&SBBufPtr->Msg, &MsgSize) != CFE_SUCCESS || MsgSize < sizeof(CFE_MSG_TelemetryHeader_t))
+    {
+        return true;
+    }
+
+    /* FNV-1a over the size and payload */
+    Hash    = 2166136261U ^ (uint32)MsgSize;
+    Payload = (const uint8 *)SBBufPtr;
+    for (i = sizeof(CFE_MSG_TelemetryHeader_t); i < MsgSize; i++)
+    {
+        Hash = (Hash ^ Payload[i]) * 16777619U;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+
+    if (Filter->HasHash && Hash == Filter->PayloadHash &&
+        OS_TimeGetTotalMilliseconds(OS_TimeSubtract(CurrTime, Filter->HeartbeatTime)) < TO_LAB_SKIP_SAME_HEARTBEAT_MSEC)
+    {
+        ++Stream->SkippedCount;
+        ++TO_LAB_Global.HkTlm.Payload.TlmSkippedCount;
+        TO_LAB_Global.HkTlm.Payload.TlmSkippedBytes += MsgSize;
+        return false;
+    }
+
+    *HashPtr = Hash;
+
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_StreamChangedCommit() -- Remember the last payload sent  */
+/*                                                                 */
+/* Hash is the value TO_LAB_StreamChangedPass() returned for it;   */
+/* 0, returned when nothing was hashed, is not remembered.         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_StreamChangedCommit(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, uint32 Hash)
+{
+    TO_LAB_StreamFilter_t *Filter = &Stream->Filter[ChannelIdx];
+
+    if (!(Stream->Options[ChannelIdx] & TO_LAB_SUB_OPT_SKIP_SAME) || Hash == 0)
+    {
+        return;
+    }
+
+    Filter->HasHash     = true;
+    Filter->PayloadHash = Hash;
+    OS_GetLocalTime(&Filter->HeartbeatTime);
+}
@@ -0,0 +1,108 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * MsgId-indexed stream table for the TO lab application
+ *
+ * Holds the per-stream state of the forwarding path.  Streams are found by
+ * MsgId through an open-addressed hash index, so the lookup done for each
+ * forwarded packet takes constant time regardless of how many streams are
+ * known.  Entries are added when a stream is subscribed and are never
+ * removed, so a pointer to an entry stays valid for the life of the app.
+ *
+ * Nothing is allocated on the forwarding path: the table is a fixed array
+ * in TO_LAB_GlobalData_t, and counting a packet is a lookup and a few adds.
+ */
+
+#ifndef TO_LAB_STREAMS_H
+#define TO_LAB_STREAMS_H
+
+#include "common_types.h"
+#include "osapi.h"
+#include "cfe_sb.h"
+#include "cfe_time.h"
+
+#include "to_lab_platform_cfg.h"
+
+/************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * Decimation state of one stream on one channel
+ */
+typedef struct
+{
+    uint16    Decimation;      /**< Send one packet of every N, 0 or 1 sends all */
+    uint16    MinIntervalMsec; /**< Minimum time between packets sent, 0 for none */
+    uint16    SkipCount;       /**< Packets dropped since the last one sent */
+    bool      HasSent;         /**< LastSendTime is valid */
+    OS_time_t LastSendTime;    /**< Time the last packet was let through */
+    bool      HasHash;         /**< PayloadHash and HeartbeatTime are valid */
+    uint32    PayloadHash;     /**< Hash of the last payload sent, for TO_LAB_SUB_OPT_SKIP_SAME */
+    OS_time_t HeartbeatTime;   /**< Time that payload was sent */
+} TO_LAB_StreamFilter_t;
+
+/**
+ * One stream known to TO_LAB
+ */
+typedef struct
+{
+    CFE_SB_MsgId_t        MsgId;
+    TO_LAB_StreamFilter_t Filter[TO_LAB_MAX_CHANNELS];
+    uint32                DecimatedCount[TO_LAB_MAX_CHANNELS]; /**< Packets dropped by Filter */
+    uint32                SkippedCount;                        /**< Unchanged packets dropped, all channels */
+    uint32                ForwardedCount;                      /**< Packets sent or queued to be sent */
+    uint32                ByteCount;                           /**< Encoded bytes sent or queued to be sent */
+    uint32                EncodeErrorCount;                    /**< Packets that failed to encode */
+    uint32                SendErrorCount;                      /**< Packets dropped on a send error or full queue */
+    CFE_TIME_SysTime_t    LastSeenTime;                        /**< Time TO_LAB last received a packet */
+    uint16                Options[TO_LAB_MAX_CHANNELS];        /**< TO_LAB_SUB_OPT_ flags */
+    uint16                DeltaEntry[TO_LAB_MAX_CHANNELS];     /**< Delta cache entry + 1, 0 if none */
+    uint16                DeltaSequence[TO_LAB_MAX_CHANNELS];  /**< Next delta sequence number */
+    uint32                WakeChannels;                        /**< Channels subscribed, one bit each */
+    uint32                SubChannels;                         /**< Channels subscribed, one bit each */
+    uint32                HighPrioChannels;                    /**< Channels subscribed on the high priority pipe */
+} TO_LAB_Stream_t;
+
+/**
+ * All streams known to TO_LAB
+ */
+typedef struct
+{
+    uint16          NumStreams;
+    uint16          Index[TO_LAB_STREAM_HASH_SIZE]; /**< Entry number + 1 in Stream, 0 if unused */
+    TO_LAB_Stream_t Stream[TO_LAB_MAX_STREAMS];
+} TO_LAB_StreamTable_t;
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+TO_LAB_Stream_t *TO_LAB_StreamLookup(CFE_SB_MsgId_t MsgId);
+TO_LAB_Stream_t *TO_LAB_StreamRegister(CFE_SB_MsgId_t MsgId);
+void             TO_LAB_StreamSetFilter(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, uint16 Decimation,
+                                        uint16 MinIntervalMsec);
+bool             TO_LAB_StreamFilterPass(TO_LAB_Stream_t *Stream, uint16 ChannelIdx);
+bool             TO_LAB_StreamChangedPass(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, const CFE_SB_Buffer_t *SBBufPtr,
+                                          uint32 *HashPtr);
+void             TO_LAB_StreamChangedCommit(TO_LAB_Stream_t *Stream, uint16 ChannelIdx, uint32 Hash);
+
+#endif
@@ -0,0 +1,423 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  This file contains the stream (TCP) output transport of the TO lab application
+ */
+
+#include <string.h>
+
+#include "cfe.h"
+
+#include "to_lab_app.h"
+#include "to_lab_tcp.h"
+#include "to_lab_eventids.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpSetDue() -- Schedule the next attempt DelayMsec ahead */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpSetDue(TO_LAB_TcpLink_t *Tcp, uint32 DelayMsec)
+{
+    OS_time_t CurrTime;
+
+    OS_GetLocalTime(&CurrTime);
+    Tcp->DueTime = OS_TimeAdd(CurrTime, OS_TimeFromTotalMilliseconds(DelayMsec));
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpIsDue() -- Check whether the next attempt is due      */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static bool TO_LAB_TcpIsDue(const TO_LAB_TcpLink_t *Tcp)
+{
+    OS_time_t CurrTime;
+
+    OS_GetLocalTime(&CurrTime);
+
+    return OS_TimeGetTotalMilliseconds(OS_TimeSubtract(Tcp->DueTime, CurrTime)) <= 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpDropSocket() -- Close the socket, keeping the buffer  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpDropSocket(TO_LAB_Channel_t *Chan)
+{
+    if (OS_ObjectIdDefined(Chan->TLMsockid))
+    {
+        OS_close(Chan->TLMsockid);
+    }
+
+    Chan->TLMsockid      = OS_OBJECT_ID_UNDEFINED;
+    Chan->Tcp.Up         = false;
+    Chan->Tcp.Connecting = false;
+    Chan->Tcp.Confirmed  = false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpConnectFailed() -- Give up a connect attempt and      */
+/*                              schedule the next one              */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpConnectFailed(TO_LAB_Channel_t *Chan, int32 OsStatus)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+
+    TO_LAB_TcpDropSocket(Chan);
+    TO_LAB_TcpSetDue(Tcp, TO_LAB_TCP_RECONNECT_MSEC);
+
+    /* Keep retrying quietly until the link comes up */
+    if (!Tcp->FailReported)
+    {
+        CFE_EVS_SendEvent(TO_LAB_TCP_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "L%d TO connect to %s port %u failed, channel %u: %d, retrying", __LINE__,
+                          Chan->tlm_dest_IP, (unsigned int)Chan->tlm_dest_port, (unsigned int)Chan->ChannelIdx,
+                          (int)OsStatus);
+        Tcp->FailReported = true;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpLost() -- Give up a connection the socket reported    */
+/*                     an error on                                 */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpLost(TO_LAB_Channel_t *Chan, int32 OsStatus)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+
+    if (!Tcp->Confirmed)
+    {
+        /* Nothing was ever written, so this was a refused connect */
+        TO_LAB_TcpConnectFailed(Chan, OsStatus);
+        return;
+    }
+
+    CFE_EVS_SendEvent(TO_LAB_TCP_ERR_EID, CFE_EVS_EventType_ERROR,
+                      "L%d TO connection to %s port %u lost, channel %u: %d", __LINE__, Chan->tlm_dest_IP,
+                      (unsigned int)Chan->tlm_dest_port, (unsigned int)Chan->ChannelIdx, (int)OsStatus);
+
+    TO_LAB_TcpDropSocket(Chan);
+    ++TO_LAB_Global.HkTlm.Payload.TcpDisconnectCount;
+
+    /* The next connection has to start on a frame boundary */
+    TO_LAB_Global.HkTlm.Payload.TcpDroppedBytes += (uint32)(Tcp->Size - Tcp->Head);
+    Tcp->Head = 0;
+    Tcp->Size = 0;
+
+    Tcp->FailReported = true;
+    TO_LAB_TcpSetDue(Tcp, TO_LAB_TCP_RECONNECT_MSEC);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpConfirmed() -- Count and report a connection once the */
+/*                          first write on it succeeds             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpConfirmed(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+
+    Tcp->Confirmed    = true;
+    Tcp->FailReported = false;
+    ++TO_LAB_Global.HkTlm.Payload.TcpConnectCount;
+
+    CFE_EVS_SendEvent(TO_LAB_TCP_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "TO connected to %s port %u, channel %u", Chan->tlm_dest_IP, (unsigned int)Chan->tlm_dest_port,
+                      (unsigned int)Chan->ChannelIdx);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpPush() -- Write buffered data the socket can take now */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpPush(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+    int32             OsStatus;
+    size_t            Pending;
+
+    while (Tcp->Up && Tcp->Head < Tcp->Size)
+    {
+        Pending  = Tcp->Size - Tcp->Head;
+        OsStatus = OS_TimedWrite(Chan->TLMsockid, &Tcp->Buffer[Tcp->Head], Pending, 0);
+
+        if (OsStatus == OS_ERROR_TIMEOUT)
+        {
+            /* Socket buffer is full, try again later rather than wait */
+            break;
+        }
+
+        if (OsStatus <= 0)
+        {
+            TO_LAB_TcpLost(Chan, OsStatus);
+            return;
+        }
+
+        if ((size_t)OsStatus < Pending)
+        {
+            ++TO_LAB_Global.HkTlm.Payload.TcpPartialWrites;
+        }
+
+        Tcp->Head += (size_t)OsStatus;
+        TO_LAB_Global.HkTlm.Payload.TcpBytesSent += (uint32)OsStatus;
+
+        if (!Tcp->Confirmed)
+        {
+            TO_LAB_TcpConfirmed(Chan);
+        }
+    }
+
+    if (Tcp->Head == Tcp->Size)
+    {
+        Tcp->Head = 0;
+        Tcp->Size = 0;
+    }
+    else
+    {
+        TO_LAB_TcpSetDue(Tcp, TO_LAB_TCP_MAX_DELAY_MSEC);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpConnected() -- Bring the link up once connected       */
+/*                                                                 */
+/* It is only counted and reported once a write succeeds on it.    */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpConnected(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+
+    Tcp->Connecting = false;
+    Tcp->Up         = true;
+    Tcp->Confirmed  = false;
+
+    /* Anything buffered while the link was down goes out now */
+    TO_LAB_TcpPush(Chan);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpPollConnect() -- Check on a connect in progress       */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+static void TO_LAB_TcpPollConnect(TO_LAB_Channel_t *Chan)
+{
+    uint32 StateFlags;
+
+    /* The socket turns writable once the handshake completes */
+    StateFlags = OS_STREAM_STATE_WRITABLE;
+    if (OS_SelectSingle(Chan->TLMsockid, &StateFlags, 0) == OS_SUCCESS &&
+        (StateFlags & OS_STREAM_STATE_WRITABLE) != 0)
+    {
+        /* A refused connect is also writable; its first write then fails */
+        TO_LAB_TcpConnected(Chan);
+    }
+    else if (TO_LAB_TcpIsDue(&Chan->Tcp))
+    {
+        TO_LAB_TcpConnectFailed(Chan, OS_ERROR_TIMEOUT);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpConnect() -- Start connecting the channel to its      */
+/*                        destination                              */
+/*                                                                 */
+/* The connect is not waited for: one still in progress is         */
+/* completed by TO_LAB_TcpService, or given up after               */
+/* TO_LAB_TCP_CONNECT_MSEC.                                        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_TcpConnect(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+    int32             OsStatus;
+
+    /* A socket whose connect failed cannot be used again */
+    TO_LAB_TcpDropSocket(Chan);
+    TO_LAB_openTLM(Chan);
+
+    OsStatus = OS_SocketConnect(Chan->TLMsockid, &Chan->DestAddr, 0);
+    if (OsStatus == OS_ERROR_TIMEOUT)
+    {
+        Tcp->Connecting = true;
+        TO_LAB_TcpSetDue(Tcp, TO_LAB_TCP_CONNECT_MSEC);
+        return;
+    }
+
+    if (OsStatus != OS_SUCCESS)
+    {
+        TO_LAB_TcpConnectFailed(Chan, OsStatus);
+        return;
+    }
+
+    TO_LAB_TcpConnected(Chan);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpClose() -- Close the connection and drop its buffer   */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_TcpClose(TO_LAB_Channel_t *Chan)
+{
+    TO_LAB_TcpDropSocket(Chan);
+
+    Chan->Tcp.Head         = 0;
+    Chan->Tcp.Size         = 0;
+    Chan->Tcp.FailReported = false;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpWrite() -- Frame one encoded packet onto the stream   */
+/*                                                                 */
+/* Returns OS_QUEUE_FULL if there was no room to buffer it         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_TcpWrite(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+    uint8            *FramePtr;
+    size_t            FrameSize;
+
+    FrameSize = TO_LAB_TCP_LENGTH_SIZE + DataSize;
+
+    if ((sizeof(Tcp->Buffer) - Tcp->Size) < FrameSize)
+    {
+        /* Make room: write what the socket takes, then move the rest to the front */
+        TO_LAB_TcpPush(Chan);
+
+        if (Tcp->Head != 0)
+        {
+            memmove(Tcp->Buffer, &Tcp->Buffer[Tcp->Head], Tcp->Size - Tcp->Head);
+            Tcp->Size -= Tcp->Head;
+            Tcp->Head = 0;
+        }
+    }
+
+    if (DataSize > TO_LAB_TCP_MAX_PACKET || (sizeof(Tcp->Buffer) - Tcp->Size) < FrameSize)
+    {
+        TO_LAB_Global.HkTlm.Payload.TcpDroppedBytes += (uint32)DataSize;
+        return OS_QUEUE_FULL;
+    }
+
+    if (Tcp->Up && Tcp->Size == Tcp->Head)
+    {
+        /* First byte waiting, it may wait this long for more to join it */
+        TO_LAB_TcpSetDue(Tcp, TO_LAB_TCP_MAX_DELAY_MSEC);
+    }
+
+    FramePtr    = &Tcp->Buffer[Tcp->Size];
+    FramePtr[0] = (uint8)(DataSize >> 8);
+    FramePtr[1] = (uint8)DataSize;
+    memcpy(&FramePtr[TO_LAB_TCP_LENGTH_SIZE], DataPtr, DataSize);
+
+    Tcp->Size += FrameSize;
+
+    if ((Tcp->Size - Tcp->Head) >= TO_LAB_TCP_COALESCE_BYTES)
+    {
+        TO_LAB_TcpPush(Chan);
+    }
+
+    return OS_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpService() -- Complete a connect, reconnect, or write  */
+/*                        buffered data once it is due             */
+/*                                                                 */
+/* With Force, buffered data is written whether it is due or not.  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void TO_LAB_TcpService(TO_LAB_Channel_t *Chan, bool Force)
+{
+    TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+
+    if (!Chan->downlink_on || Chan->suppress_sendto)
+    {
+        return;
+    }
+
+    if (Tcp->Connecting)
+    {
+        TO_LAB_TcpPollConnect(Chan);
+    }
+    else if (!Tcp->Up)
+    {
+        if (TO_LAB_TcpIsDue(Tcp))
+        {
+            TO_LAB_TcpConnect(Chan);
+        }
+    }
+    else if (Tcp->Head != Tcp->Size && (Force || TO_LAB_TcpIsDue(Tcp)))
+    {
+        TO_LAB_TcpPush(Chan);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* TO_LAB_TcpMsecToDeadline() -- Time left before the next attempt */
+/*                                                                 */
+/* Returns TO_LAB_TASK_MSEC if nothing is waiting                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 TO_LAB_TcpMsecToDeadline(const TO_LAB_Channel_t *Chan)
+{
+    const TO_LAB_TcpLink_t *Tcp = &Chan->Tcp;
+    OS_time_t               CurrTime;
+    int64                   LeftMsec;
+
+    if (!Chan->downlink_on || Chan->suppress_sendto || (Tcp->Up && Tcp->Head == Tcp->Size))
+    {
+        return TO_LAB_TASK_MSEC;
+    }
+
+    OS_GetLocalTime(&CurrTime);
+    LeftMsec = OS_TimeGetTotalMilliseconds(OS_TimeSubtract(Tcp->DueTime, CurrTime));
+
+    if (LeftMsec <= 0)
+    {
+        return 0;
+    }
+    if (Tcp->Connecting && LeftMsec > TO_LAB_TCP_MAX_DELAY_MSEC)
+    {
+        /* Look in on the handshake as often as buffered data would be written */
+        return TO_LAB_TCP_MAX_DELAY_MSEC;
+    }
+    if (LeftMsec > TO_LAB_TASK_MSEC)
+    {
+        return TO_LAB_TASK_MSEC;
+    }
+
+    return (int32)LeftMsec;
+}
@@ -0,0 +1,78 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * @file
+ *
+ * Stream (TCP) output transport of the TO lab application
+ *
+ * A channel enabled with TO_LAB_TRANSPORT_TCP sends each encoded packet on
+ * a TCP connection to its destination, preceded by its length:
+ *
+ *     Offset  Size  Field
+ *     0       2     Length N of the packet in bytes, big endian
+ *     2       N     Packet, exactly as it would be sent unbatched over UDP
+ *
+ * and the next length follows immediately.
+ *
+ * Framed packets are appended to a per-channel buffer that is written to
+ * the socket once TO_LAB_TCP_COALESCE_BYTES are waiting, or once the
+ * oldest of them has waited TO_LAB_TCP_MAX_DELAY_MSEC, so the stack sees
+ * few large writes.  Writes never wait for the socket; a write it only
+ * partly accepts is resumed where it stopped on a later attempt.
+ *
+ * Connecting never waits: the handshake is checked on each service pass,
+ * and given up after TO_LAB_TCP_CONNECT_MSEC.  A refused socket also turns
+ * writable, so a connection is only counted and reported as made once its
+ * first write succeeds; until then a failure is handled as a failed
+ * connect, reported once until the link comes up.  A refused, failed or
+ * lost connection is retried every TO_LAB_TCP_RECONNECT_MSEC, and packets
+ * produced meanwhile are buffered while there is room.  Data left unsent
+ * on a lost connection is dropped, so a new connection always starts on a
+ * frame boundary.
+ *
+ * Batching, compression, the retry queue and the sender task all work on
+ * datagrams, and do not apply to a TCP channel.
+ */
+
+#ifndef TO_LAB_TCP_H
+#define TO_LAB_TCP_H
+
+#include "common_types.h"
+#include "osapi.h"
+
+#include "to_lab_output.h"
+
+/************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define TO_LAB_TCP_LENGTH_SIZE 2
+#define TO_LAB_TCP_MAX_PACKET  0xFFFF
+
+/************************************************************************
+ * Function Prototypes
+ ************************************************************************/
+
+void  TO_LAB_TcpConnect(TO_LAB_Channel_t *Chan);
+void  TO_LAB_TcpClose(TO_LAB_Channel_t *Chan);
+int32 TO_LAB_TcpWrite(TO_LAB_Channel_t *Chan, const void *DataPtr, size_t DataSize);
+void  TO_LAB_TcpService(TO_LAB_Channel_t *Chan, bool Force);
+int32 TO_LAB_TcpMsecToDeadline(const TO_LAB_Channel_t *Chan);
+
+#endif
@@ -59,47 +59,73 @@
 #include "lc_msgids.h"
 #endif
 
-TO_LAB_Subs_t TO_LAB_Subs = {.Subs = {/* CFS App Subscriptions */
-                                      {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_DATA_TYPES_MID), {0, 0}, 4},
-
-                                      /* cFE Core subscriptions */
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_SB_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_TBL_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_TIME_HK_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_TIME_DIAG_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_SB_STATS_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_TBL_REG_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_LONG_EVENT_MSG_MID), {0, 0}, 32},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_SHORT_EVENT_MSG_MID), {0, 0}, 32},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_APP_TLM_MID), {0, 0}, 4},
-                                      {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_MEMSTATS_TLM_MID), {0, 0}, 4},
+/*
+ * Channel 0 carries the legacy subscription list.  Other channels start empty
+ * and are populated at runtime with the channel add-packet command.  Every
+ * channel's list, even an empty one, ends with a CFE_SB_MSGID_RESERVED entry;
+ * list one section per channel here.
+ *
+ * Events and housekeeping are subscribed at TO_LAB_PRIO_HIGH so they are
+ * not held up behind bulk telemetry when the byte budget runs out.
+ *
+ * Entry fields after BufLimit are optional and default to 0 (no limit):
+ * BytesPerSec, PktsPerSec, Decimation (send 1 of every N), MinIntervalMsec
+ * and Options.  For example, {MID, {0, 0}, 4, 0, 0, 10, 0} forwards one
+ * packet in ten, and {MID, {0, 0}, 4, 0, 0, 0, 0, TO_LAB_SUB_OPT_DELTA}
+ * sends each packet as a delta against the previous one.
+ * TO_LAB_SUB_OPT_SKIP_SAME drops packets whose payload has not changed
+ * since the last one sent, sending one every TO_LAB_SKIP_SAME_HEARTBEAT_MSEC
+ * regardless.
+ */
+TO_LAB_Subs_t TO_LAB_Subs = {.Channel = {
+    [0] = {.Subs = {/* CFS App Subscriptions */
+        {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_DATA_TYPES_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_STREAM_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(TO_LAB_HK_EXT_TLM_MID), {0, 0}, 4},
+
+        /* cFE Core subscriptions */
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_SB_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_TBL_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_TIME_HK_TLM_MID), {TO_LAB_PRIO_HIGH, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_TIME_DIAG_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_SB_STATS_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_TBL_REG_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_LONG_EVENT_MSG_MID), {TO_LAB_PRIO_HIGH, 0}, 32},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_EVS_SHORT_EVENT_MSG_MID), {TO_LAB_PRIO_HIGH, 0}, 32},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_APP_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CFE_ES_MEMSTATS_TLM_MID), {0, 0}, 4},
 
 #ifdef HAVE_CI_LAB
-                                      {CFE_SB_MSGID_WRAP_VALUE(CI_LAB_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(CI_LAB_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_SAMPLE_APP
-                                      {CFE_SB_MSGID_WRAP_VALUE(SAMPLE_APP_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(SAMPLE_APP_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_HS
-                                      {CFE_SB_MSGID_WRAP_VALUE(HS_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(HS_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_FM
-                                      {CFE_SB_MSGID_WRAP_VALUE(FM_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(FM_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_SC
-                                      {CFE_SB_MSGID_WRAP_VALUE(SC_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(SC_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_DS
-                                      {CFE_SB_MSGID_WRAP_VALUE(DS_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(DS_HK_TLM_MID), {0, 0}, 4},
 #endif
 #ifdef HAVE_LC
-                                      {CFE_SB_MSGID_WRAP_VALUE(LC_HK_TLM_MID), {0, 0}, 4},
+        {CFE_SB_MSGID_WRAP_VALUE(LC_HK_TLM_MID), {0, 0}, 4},
 #endif
 
-                                      /* CFE_SB_MSGID_RESERVED entry to mark the end of valid MsgIds */
-                                      {CFE_SB_MSGID_RESERVED, {0, 0}, 0}}};
+        /* CFE_SB_MSGID_RESERVED entry to mark the end of valid MsgIds */
+        {CFE_SB_MSGID_RESERVED, {0, 0}, 0}}},
+
+    /* Channel 1 starts empty */
+    [1] = {.Subs = {{CFE_SB_MSGID_RESERVED, {0, 0}, 0}}}}};
+
+CompileTimeAssert(TO_LAB_MAX_CHANNELS == 2, TO_LAB_Subs_NeedsOneSectionPerChannel);
 
 CFE_TBL_FILEDEF(TO_LAB_Subs, TO_LAB_APP.TO_LAB_Subs, TO Lab Sub Tbl, to_lab_sub.tbl)
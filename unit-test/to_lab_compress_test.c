@@ -0,0 +1,244 @@
+/************************************************************************
+ * NASA Docket No. GSC-18,719-1, and identified as “core Flight System: Bootes”
+ *
+ * Copyright (c) 2020 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space Administration.
+ * All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ************************************************************************/
+
+/**
+ * \file
+ *  Round trip tests of the TO lab datagram compressor against the reference
+ *  decoder
+ */
+
+#include <string.h>
+
+#include "utassert.h"
+#include "uttest.h"
+
+/*
+ * The compressor leaves every datagram alone unless it is enabled in the
+ * configuration, so both files are built here with it enabled.  Neither
+ * depends on the rest of the application.
+ */
+#include "to_lab_platform_cfg.h"
+#undef TO_LAB_COMPRESS_ENABLE
+#define TO_LAB_COMPRESS_ENABLE true
+
+#include "to_lab_compress.c"
+#include "to_lab_decompress.c"
+
+#define UT_HK_PACKET_SIZE 128
+
+static TO_LAB_Compress_t   UT_Comp;
+static TO_LAB_Decompress_t UT_Decomp;
+static uint8               UT_Data[TO_LAB_COMPRESS_MAX_INPUT];
+static uint32              UT_RandState;
+
+/*
+ * --------------------------------------------
+ * Fill a buffer with repeatable pseudo-random bytes
+ * --------------------------------------------
+ */
+static void UT_FillRandom(uint8 *Data, size_t Size)
+{
+    size_t i;
+
+    for (i = 0; i < Size; ++i)
+    {
+        UT_RandState = (UT_RandState * 1103515245U) + 12345U;
+        Data[i]      = (uint8)(UT_RandState >> 16);
+    }
+}
+
+/*
+ * --------------------------------------------
+ * Fill a buffer like a housekeeping packet: a fixed header, a counter, and
+ * fields that change slowly
+ * --------------------------------------------
+ */
+static void UT_FillHk(uint8 *Data, size_t Size, uint32 Count)
+{
+    size_t i;
+
+    for (i = 0; i < Size; ++i)
+    {
+        Data[i] = (uint8)(i < 16 ? (0xA0 + i) : ((i / 8) + (Count / 10)));
+    }
+
+    Data[6] = (uint8)(Count >> 8);
+    Data[7] = (uint8)Count;
+}
+
+/*
+ * --------------------------------------------
+ * Compress one datagram and feed the result to the decoder.  Returns the
+ * flags of the compressed datagram.
+ * --------------------------------------------
+ */
+static uint8 UT_RoundTrip(const uint8 *Data, size_t Size)
+{
+    const uint8 *DataOut = NULL;
+    size_t       SizeOut = 0;
+    size_t       CompSize;
+
+    CompSize = TO_LAB_CompressDatagram(&UT_Comp, Data, Size);
+    UtAssert_True(CompSize > TO_LAB_COMPRESS_HDR_SIZE, "Compressed size %lu", (unsigned long)CompSize);
+
+    UtAssert_True(TO_LAB_CompressDecode(&UT_Decomp, UT_Comp.Output, CompSize, &DataOut, &SizeOut),
+                  "Datagram of %lu bytes decodes", (unsigned long)Size);
+    UtAssert_UINT32_EQ(SizeOut, Size);
+    if (DataOut != NULL && SizeOut == Size)
+    {
+        UtAssert_MemCmp(DataOut, Data, Size, "Decoded datagram matches the original");
+    }
+
+    return UT_Comp.Output[3];
+}
+
+/*
+ * --------------------------------------------
+ * Start each test with a fresh compressor and decoder
+ * --------------------------------------------
+ */
+static void UT_Setup(void)
+{
+    memset(&UT_Comp, 0, sizeof(UT_Comp));
+    memset(&UT_Decomp, 0, sizeof(UT_Decomp));
+    TO_LAB_CompressInit(&UT_Comp, true, 0);
+    UT_RandState = 1;
+}
+
+static void Test_CompressRandom(void)
+{
+    uint32 i;
+    size_t Size;
+
+    for (i = 0; i < 20; ++i)
+    {
+        Size = 1 + (i * 97) % TO_LAB_COMPRESS_MAX_INPUT;
+        UT_FillRandom(UT_Data, Size);
+        UT_RoundTrip(UT_Data, Size);
+    }
+
+    /* Too large to compress: sent as it is */
+    UtAssert_UINT32_EQ(TO_LAB_CompressDatagram(&UT_Comp, UT_Data, TO_LAB_COMPRESS_MAX_INPUT + 1), 0);
+    UtAssert_UINT32_EQ(TO_LAB_CompressDatagram(&UT_Comp, UT_Data, 0), 0);
+}
+
+static void Test_CompressHk(void)
+{
+    uint32 i;
+    uint8  Flags;
+
+    /* Enough packets to trim the history several times */
+    for (i = 0; i < (4 * TO_LAB_COMPRESS_WINDOW / UT_HK_PACKET_SIZE); ++i)
+    {
+        UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, i);
+        Flags = UT_RoundTrip(UT_Data, UT_HK_PACKET_SIZE);
+
+        if (i != 0)
+        {
+            UtAssert_True((Flags & TO_LAB_COMPRESS_FLAG_STORED) == 0, "HK packet %lu is compressed",
+                          (unsigned long)i);
+        }
+    }
+}
+
+static void Test_CompressStoredReset(void)
+{
+    uint32 i;
+    uint8  Flags;
+
+    TO_LAB_CompressInit(&UT_Comp, true, 3);
+
+    for (i = 0; i < 9; ++i)
+    {
+        /* Alternate incompressible and repetitive datagrams */
+        if (i & 1)
+        {
+            UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, 0);
+        }
+        else
+        {
+            UT_FillRandom(UT_Data, UT_HK_PACKET_SIZE);
+        }
+
+        Flags = UT_RoundTrip(UT_Data, UT_HK_PACKET_SIZE);
+
+        UtAssert_True(((Flags & TO_LAB_COMPRESS_FLAG_RESET) != 0) == ((i % 3) == 0), "Datagram %lu reset flag",
+                      (unsigned long)i);
+        UtAssert_True(((Flags & TO_LAB_COMPRESS_FLAG_STORED) != 0) == ((i & 1) == 0), "Datagram %lu stored flag",
+                      (unsigned long)i);
+    }
+}
+
+static void Test_CompressSequenceGap(void)
+{
+    const uint8 *DataOut;
+    size_t       SizeOut;
+    size_t       CompSize;
+    uint32       i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, i);
+        UT_RoundTrip(UT_Data, UT_HK_PACKET_SIZE);
+    }
+
+    /* Lose one datagram: nothing decodes until the history is reset */
+    UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, 3);
+    UtAssert_True(TO_LAB_CompressDatagram(&UT_Comp, UT_Data, UT_HK_PACKET_SIZE) != 0, "Lost datagram compressed");
+
+    for (i = 4; i < 6; ++i)
+    {
+        UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, i);
+        CompSize = TO_LAB_CompressDatagram(&UT_Comp, UT_Data, UT_HK_PACKET_SIZE);
+        UtAssert_BOOL_FALSE(TO_LAB_CompressDecode(&UT_Decomp, UT_Comp.Output, CompSize, &DataOut, &SizeOut));
+    }
+
+    UT_Comp.ResetPending = true;
+    UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, 6);
+    UT_RoundTrip(UT_Data, UT_HK_PACKET_SIZE);
+    UT_FillHk(UT_Data, UT_HK_PACKET_SIZE, 7);
+    UT_RoundTrip(UT_Data, UT_HK_PACKET_SIZE);
+}
+
+static void Test_CompressLongLengths(void)
+{
+    uint8 Flags;
+
+    /* 300 literals then a 300 byte match, both past the 255 extension byte */
+    UT_FillRandom(UT_Data, 300);
+    memcpy(&UT_Data[300], UT_Data, 300);
+    Flags = UT_RoundTrip(UT_Data, 600);
+
+    UtAssert_True((Flags & TO_LAB_COMPRESS_FLAG_STORED) == 0, "Long match is compressed");
+    UtAssert_UINT32_EQ(UT_Comp.Output[TO_LAB_COMPRESS_HDR_SIZE], 0xFF);
+    UtAssert_UINT32_EQ(UT_Comp.Output[TO_LAB_COMPRESS_HDR_SIZE + 1], 255);
+
+    /* A run of one byte value is a match overlapping its own output */
+    memset(UT_Data, 0x5A, TO_LAB_COMPRESS_MAX_INPUT);
+    Flags = UT_RoundTrip(UT_Data, TO_LAB_COMPRESS_MAX_INPUT);
+    UtAssert_True((Flags & TO_LAB_COMPRESS_FLAG_STORED) == 0, "Run is compressed");
+}
+
+void UtTest_Setup(void)
+{
+    UtTest_Add(Test_CompressRandom, UT_Setup, NULL, "Test_CompressRandom");
+    UtTest_Add(Test_CompressHk, UT_Setup, NULL, "Test_CompressHk");
+    UtTest_Add(Test_CompressStoredReset, UT_Setup, NULL, "Test_CompressStoredReset");
+    UtTest_Add(Test_CompressSequenceGap, UT_Setup, NULL, "Test_CompressSequenceGap");
+    UtTest_Add(Test_CompressLongLengths, UT_Setup, NULL, "Test_CompressLongLengths");
+}